@@ -0,0 +1,180 @@
+#! /usr/bin/env python3
+#
+# convert images & videos into a pre-decoded frame pack for Styler
+#
+# all frames are decoded once and stored as fixed-size RGB in a single file
+# with a frame index, Styler memory maps the file and plays frames without
+# decoding or copying, see src/FramePack.h:
+# * images are shown for --image-time ms each
+# * video frames are shown for 1 / video fps each
+# * frames are resized to --size or the size of the first frame, either
+#   stretched like the model input or, with --pad, fit keeping aspect ratio &
+#   padded with black borders
+# * each frame starts on a page boundary
+#
+# requires: python3, numpy, pillow, opencv-python (for videos only)
+#
+# usage: scripts/make_framepack.py [-o DEST] SRC [SRC ...]
+#
+# SRC may be image or video files or directories of them, default DEST is
+# bin/data/frames.pack which Styler opens with the b key or --pack
+#
+# Dan Wilcox ZKM | Hertz-Lab 2023
+
+import argparse
+import os
+import struct
+import sys
+
+import numpy as np
+from PIL import Image
+
+##### variables
+
+# script dir, used for default paths
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# file format, must match src/FramePack.h
+MAGIC = b"STYLPAK\0"
+VERSION = 1
+HEADER = struct.Struct("<8sIIIIII") # magic version count width height channels reserved
+ENTRY = struct.Struct("<QII") # offset duration reserved
+PAGE_SIZE = 4096
+
+# file extensions, same as the Styler image & video listings
+IMAGE_EXTS = [".jpg", ".jpeg", ".png", ".bmp", ".gif", ".tif", ".tiff"]
+VIDEO_EXTS = [".mov", ".mp4", ".m4v", ".avi", ".mkv", ".webm"]
+
+##### functions
+
+# expand directories to sorted media file paths
+def list_paths(srcs):
+	paths = []
+	for src in srcs:
+		if os.path.isdir(src):
+			for name in sorted(os.listdir(src)):
+				path = os.path.join(src, name)
+				if os.path.splitext(name)[1].lower() in IMAGE_EXTS + VIDEO_EXTS:
+					paths.append(path)
+		else:
+			paths.append(src)
+	return paths
+
+# yield (RGB numpy array, duration ms) for each frame in an image or video
+def read_frames(path, image_time):
+	ext = os.path.splitext(path)[1].lower()
+	if ext in VIDEO_EXTS:
+		import cv2
+		video = cv2.VideoCapture(path)
+		if not video.isOpened():
+			print("could not open " + path)
+			return
+		fps = video.get(cv2.CAP_PROP_FPS)
+		duration = int(round(1000 / fps)) if fps > 0 else 33
+		while True:
+			ok, frame = video.read()
+			if not ok:
+				break
+			yield cv2.cvtColor(frame, cv2.COLOR_BGR2RGB), duration
+		video.release()
+	else:
+		try:
+			image = Image.open(path).convert("RGB")
+		except OSError:
+			print("could not open " + path)
+			return
+		yield np.asarray(image), image_time
+
+# resize to exact size, ignores aspect ratio to match the model input
+def resize(frame, size):
+	if frame.shape[1] == size[0] and frame.shape[0] == size[1]:
+		return frame
+	image = Image.fromarray(frame).resize(size, Image.BILINEAR)
+	return np.asarray(image)
+
+# fit into size keeping aspect ratio, centered & padded with black
+def pad(frame, size):
+	h, w = frame.shape[0], frame.shape[1]
+	if w == size[0] and h == size[1]:
+		return frame
+	scale = min(size[0] / w, size[1] / h)
+	fit = (max(int(round(w * scale)), 1), max(int(round(h * scale)), 1))
+	padded = np.zeros((size[1], size[0], 3), dtype=np.uint8)
+	x, y = (size[0] - fit[0]) // 2, (size[1] - fit[1]) // 2
+	padded[y:y + fit[1], x:x + fit[0]] = resize(frame, fit)
+	return padded
+
+# round up to the next page boundary
+def align(offset):
+	return (offset + PAGE_SIZE - 1) // PAGE_SIZE * PAGE_SIZE
+
+# parse WxH size
+def parse_size(size):
+	try:
+		w, h = size.lower().split("x")
+		return int(w), int(h)
+	except ValueError:
+		raise argparse.ArgumentTypeError("invalid size: " + size)
+
+##### parser
+
+parser = argparse.ArgumentParser(description="convert images & videos into a Styler frame pack")
+parser.add_argument("src", nargs="+",
+	help="image or video files or directories")
+parser.add_argument("-o", "--output", default=os.path.join(SCRIPT_DIR, "../bin/data/frames.pack"),
+	help="frame pack output path, default bin/data/frames.pack")
+parser.add_argument("-s", "--size", type=parse_size, default=None,
+	help="frame size, WxH ie. 640x480, use the model input size to skip resizing in Styler, default first frame size")
+parser.add_argument("-p", "--pad", action="store_true",
+	help="fit frames into size keeping aspect ratio with black borders, default stretch")
+parser.add_argument("-t", "--image-time", type=int, default=3000,
+	help="image display time in ms, default 3000")
+
+##### main
+
+args = parser.parse_args()
+paths = list_paths(args.src)
+if len(paths) == 0:
+	print("no images or videos found")
+	sys.exit(1)
+
+# frames are written to a temp file first, the index is written at the end
+# once the count is known, so the frames can be streamed
+tmp = args.output + ".tmp"
+size = args.size
+entries = []
+with open(tmp, "wb") as f:
+	f.write(b"\0" * HEADER.size) # placeholder
+	for path in paths:
+		print("adding " + path)
+		for frame, duration in read_frames(path, args.image_time):
+			if size is None:
+				size = (frame.shape[1], frame.shape[0])
+			frame = pad(frame, size) if args.pad else resize(frame, size)
+			data = np.ascontiguousarray(frame, dtype=np.uint8).tobytes()
+			offset = align(f.tell())
+			f.seek(offset)
+			f.write(data)
+			entries.append((offset, duration))
+if len(entries) == 0:
+	os.remove(tmp)
+	print("no frames found")
+	sys.exit(1)
+
+# header & index come first in the file, so shift the frames back
+index_size = HEADER.size + ENTRY.size * len(entries)
+shift = align(index_size) - align(HEADER.size)
+with open(tmp, "rb") as src, open(args.output, "wb") as dest:
+	dest.write(HEADER.pack(MAGIC, VERSION, len(entries), size[0], size[1], 3, 0))
+	for offset, duration in entries:
+		dest.write(ENTRY.pack(offset + shift, duration, 0))
+	frame_size = size[0] * size[1] * 3
+	for offset, duration in entries:
+		src.seek(offset)
+		dest.seek(offset + shift)
+		dest.write(src.read(frame_size))
+os.remove(tmp)
+
+print("wrote " + args.output)
+print(str(len(entries)) + " frames " + str(size[0]) + "x" + str(size[1]) + ", " +
+      str(os.path.getsize(args.output) // (1024 * 1024)) + " MB")
@@ -0,0 +1,198 @@
+#! /usr/bin/env python3
+#
+# offline optimization for the arbitrary style transfer SavedModel
+#
+# loads the model once and writes a new SavedModel which Styler can load
+# directly and much faster:
+# * strip unused signatures, only serving_default is kept
+# * freeze variables into constants, no variable restore on load
+# * fold constants & simplify arithmetic with grappler
+# * store float16-compressed weights (optional, on by default)
+#
+# requires: python3, tensorflow 2.x, numpy
+#
+# usage: scripts/optimize_model.py [SRC] [DEST]
+#
+# default SRC is bin/data/model & default DEST is bin/data/model-optimized,
+# Styler uses bin/data/model-optimized automatically if it exists
+#
+# Dan Wilcox ZKM | Hertz-Lab 2023
+
+import argparse
+import os
+import shutil
+import sys
+import time
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.core.framework import graph_pb2, types_pb2
+from tensorflow.core.protobuf import config_pb2, meta_graph_pb2
+from tensorflow.python.framework import convert_to_constants
+from tensorflow.python.grappler import tf_optimizer
+
+##### variables
+
+# script dir, used for default paths
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# signature and input names expected by ofxStyleTransfer
+SIGNATURE = "serving_default"
+INPUTS = ["placeholder", "placeholder_1"]
+
+# min number of elements for a weight to be stored as float16,
+# small constants like shapes & scalars are left as is
+FLOAT16_MIN_ELEMENTS = 256
+
+##### functions
+
+# freeze variables of a concrete function into constants
+def freeze(func):
+	frozen = convert_to_constants.convert_variables_to_constants_v2(func)
+	return frozen, frozen.graph.as_graph_def()
+
+# run grappler constant folding & arithmetic optimizations on a graph
+def fold(graph_def, graph, fetches):
+	meta = tf.compat.v1.train.export_meta_graph(graph_def=graph_def, graph=graph)
+	fetch = meta_graph_pb2.CollectionDef()
+	for name in fetches:
+		fetch.node_list.value.append(name)
+	meta.collection_def["train_op"].CopyFrom(fetch) # grappler keeps these
+	config = config_pb2.ConfigProto()
+	rewrite = config.graph_options.rewrite_options
+	rewrite.optimizers.extend(["pruning", "constfold", "arithmetic", "dependency", "function"])
+	rewrite.meta_optimizer_iterations = 2
+	return tf_optimizer.OptimizeGraph(config, meta)
+
+# replace large float32 constants with float16 constants & a cast, the cast
+# keeps the original node name so consumers are unchanged
+def compress_float16(graph_def):
+	out = graph_pb2.GraphDef()
+	out.versions.CopyFrom(graph_def.versions)
+	out.library.CopyFrom(graph_def.library)
+	count = 0
+	for node in graph_def.node:
+		if node.op == "Const" and node.attr["dtype"].type == types_pb2.DT_FLOAT:
+			value = tf.make_ndarray(node.attr["value"].tensor)
+			if value.size >= FLOAT16_MIN_ELEMENTS:
+				half = out.node.add()
+				half.op = "Const"
+				half.name = node.name + "/float16"
+				half.device = node.device
+				half.input.extend(node.input) # control deps, if any
+				half.attr["dtype"].type = types_pb2.DT_HALF
+				half.attr["value"].tensor.CopyFrom(
+					tf.make_tensor_proto(value.astype(np.float16)))
+				cast = out.node.add()
+				cast.op = "Cast"
+				cast.name = node.name
+				cast.device = node.device
+				cast.input.append(half.name)
+				cast.attr["SrcT"].type = types_pb2.DT_HALF
+				cast.attr["DstT"].type = types_pb2.DT_FLOAT
+				cast.attr["Truncate"].b = False
+				count += 1
+				continue
+		out.node.add().CopyFrom(node)
+	print("compressed " + str(count) + " weights to float16")
+	return out
+
+# wrap an optimized graph in a module with a single serving signature
+def wrap(graph_def, specs, feeds, fetches, output_key):
+	imported = tf.compat.v1.wrap_function(
+		lambda: tf.compat.v1.import_graph_def(graph_def, name=""), [])
+	pruned = imported.prune(
+		feeds=[imported.graph.as_graph_element(name) for name in feeds],
+		fetches=[imported.graph.as_graph_element(name) for name in fetches])
+
+	module = tf.Module()
+
+	# tiny marker variable: reading it keeps the signature stateful so the
+	# output op is still named "StatefulPartitionedCall" as the app expects
+	module.optimized = tf.Variable(1, dtype=tf.int32, trainable=False)
+
+	@tf.function(input_signature=[tf.TensorSpec(specs[n].shape, specs[n].dtype, name=n) for n in INPUTS])
+	def serve(placeholder, placeholder_1):
+		with tf.control_dependencies([module.optimized.read_value()]):
+			output = tf.identity(pruned(placeholder, placeholder_1)[0])
+		return {output_key: output}
+
+	module.serve = serve
+	return module
+
+# run both models on the same random input & return the max abs difference
+def compare(src, dest):
+	a = tf.saved_model.load(src).signatures[SIGNATURE]
+	b = tf.saved_model.load(dest).signatures[SIGNATURE]
+	image = tf.random.uniform([1, 256, 256, 3])
+	style = tf.random.uniform([1, 256, 256, 3])
+	out_a = list(a(placeholder=image, placeholder_1=style).values())[0]
+	out_b = list(b(placeholder=image, placeholder_1=style).values())[0]
+	return float(tf.reduce_max(tf.abs(out_a - out_b)))
+
+# total size of all files in a dir
+def dir_size(path):
+	size = 0
+	for root, dirs, files in os.walk(path):
+		for f in files:
+			size += os.path.getsize(os.path.join(root, f))
+	return size
+
+##### parse command line arguments
+
+parser = argparse.ArgumentParser(description="optimize the style transfer SavedModel for fast loading")
+parser.add_argument("src", nargs="?", default=os.path.join(SCRIPT_DIR, "../bin/data/model"),
+	help="source SavedModel dir, default bin/data/model")
+parser.add_argument("dest", nargs="?", default=os.path.join(SCRIPT_DIR, "../bin/data/model-optimized"),
+	help="destination SavedModel dir, default bin/data/model-optimized")
+parser.add_argument("--no-float16", action="store_true",
+	help="keep float32 weights")
+parser.add_argument("--no-check", action="store_true",
+	help="skip comparing the output of the original & optimized models")
+args = parser.parse_args()
+
+##### go
+
+if not os.path.isdir(args.src):
+	print("model not found: " + args.src + ", run download_model.sh first?")
+	sys.exit(1)
+
+# load & strip unused signatures
+loaded = tf.saved_model.load(args.src)
+if SIGNATURE not in loaded.signatures:
+	print("model has no " + SIGNATURE + " signature")
+	sys.exit(1)
+func = loaded.signatures[SIGNATURE]
+specs = func.structured_input_signature[1]
+for name in INPUTS:
+	if name not in specs:
+		print("model is missing expected input: " + name)
+		sys.exit(1)
+output_key = list(func.structured_outputs.keys())[0]
+print("stripped " + str(len(loaded.signatures) - 1) + " unused signature(s)")
+
+# freeze & fold
+frozen, graph_def = freeze(func)
+feeds = [name + ":0" for name in INPUTS]
+fetches = [t.name for t in frozen.outputs]
+print("frozen graph: " + str(len(graph_def.node)) + " nodes")
+graph_def = fold(graph_def, frozen.graph, [name.split(":")[0] for name in fetches])
+print("folded graph: " + str(len(graph_def.node)) + " nodes")
+if not args.no_float16:
+	graph_def = compress_float16(graph_def)
+
+# write
+if os.path.exists(args.dest):
+	shutil.rmtree(args.dest)
+module = wrap(graph_def, specs, feeds, fetches, output_key)
+tf.saved_model.save(module, args.dest, signatures={SIGNATURE: module.serve})
+print("wrote " + args.dest)
+print("size: " + str(dir_size(args.src) // 1024) + " KB -> " +
+      str(dir_size(args.dest) // 1024) + " KB")
+
+# check
+if not args.no_check:
+	start = time.time()
+	tf.saved_model.load(args.dest)
+	print("optimized load: " + "{:.2f}".format(time.time() - start) + " s")
+	print("max output difference: " + "{:.4f}".format(compare(args.src, args.dest)))
@@ -34,12 +34,16 @@ bool Commandline::parse(int argc, char **argv) {
 	// local options, the rest are ofAppSettings instance variables
 	std::string size = "";
 	std::string styleSize = "";
+	std::string dev = "";
+	std::string tiles = "";
+	float styleLive = 0;
 	bool list = false;
 	bool styleMirror = false;
 	bool styleFlip = false;
 	bool verbose = false;
 	bool version = false;
 	std::string settings = "";
+	std::string pack = "";
 
 	// no style camera by default
 	app->styleCameraSettings.device = -1;
@@ -47,15 +51,26 @@ bool Commandline::parse(int argc, char **argv) {
 	parser.add_flag("-f,--fullscreen", app->startFullscreen, "start in fullscreen");
 	parser.add_flag("-a,--auto", app->styleAuto, "enable auto style change");
 	parser.add_option("--auto-time", app->styleAutoTime, "set camera auto style change time in s, default " + ofToString(app->styleAutoTime));
+	parser.add_flag("--shuffle", app->styleShuffle, "shuffle auto style change order");
 	parser.add_option("-p,--port", app->osc.port, "OSC listen port, default none");
 	parser.add_flag(  "-l,--list", list, "list camera devices and exit");
-	parser.add_option("-d,--dev", app->cameraSettings.device, "camera device number, default " + ofToString(app->cameraSettings.device));
+	parser.add_option("-d,--dev", dev, "camera device number, default " + ofToString(app->cameraSettings.device) +
+		", or comma separated numbers for multiple cameras batched through the model ie. 0,1,2,3");
 	parser.add_option("-r,--rate", app->cameraSettings.rate, "desired camera framerate, default " + ofToString(app->cameraSettings.rate));
 	parser.add_option("-s,--size", size, "desired camera size, default " +
 		ofToString(app->cameraSettings.size.width) + "x" + ofToString(app->cameraSettings.size.height));
 	parser.add_flag("--mirror", app->cameraSettings.mirror.horz, "mirror camera horizontally");
 	parser.add_flag("--flip", app->cameraSettings.mirror.vert, "flip camera vertically");
 	parser.add_flag("--static-size", app->staticSize, "disable dynamic input -> output size handling");
+	parser.add_option("--image-cache", app->imageCacheSize, "decoded image cache size in MB, default " + ofToString(app->imageCacheSize));
+	parser.add_option("--image-prefetch", app->imagePrefetch, "images to decode ahead & behind, default " + ofToString(app->imagePrefetch));
+	parser.add_flag("--video-thread", app->videoThread, "decode video on its own thread");
+	parser.add_flag("--lockstep", app->lockstep, "advance video frames only when the model is ready, no dropped frames");
+	parser.add_option("--input", app->input, "stream input: - for stdin or pipe:PATH, y4m or raw rgb of --size, shm:/NAME, v4l2:/dev/videoN, or mjpeg:/dev/videoN");
+	parser.add_option("--watch", app->watch.dir, "start with hot folder input, stylize images added to DIR (linux)");
+	parser.add_option("--watch-output", app->watch.output, "hot folder result DIR, default " + app->watch.output);
+	parser.add_option("--watch-threads", app->watch.threads, "hot folder decode & write threads, default " + ofToString(app->watch.threads));
+	parser.add_option("--pack", pack, "start with frame pack input file, see scripts/make_framepack.py");
 	parser.add_option("--style-dev", app->styleCameraSettings.device, "optional second style camera device number");
 	parser.add_option("--style-rate", app->cameraSettings.rate, "desired style camera framerate, default " + ofToString(app->styleCameraSettings.rate));
 	parser.add_option("--style-size", styleSize, "desired style camera size, default " +
@@ -64,6 +79,12 @@ bool Commandline::parse(int argc, char **argv) {
 	parser.add_flag("--style-flip", app->styleCameraSettings.mirror.vert, "flip style camera vertically");
 	parser.add_flag("--style-save", app->styleSave, "save style images when taking");
 	parser.add_flag("--style-pip", app->stylePip, "show style picture in picture");
+	parser.add_option("--style-live", styleLive, "continuous style from style camera at rate in Hz ie. 2");
+	parser.add_flag("--foveate", app->fovea.enabled, "process region of interest at full res, low res elsewhere");
+	parser.add_flag("--foveate-track", app->fovea.track, "foveated region of interest follows motion");
+	parser.add_option("--tiles", tiles, "process tiles progressively, CxR grid ie. 2x2");
+	parser.add_option("--tiles-per-frame", app->tiles.perFrame, "tiles processed per model pass, default " + ofToString(app->tiles.perFrame));
+	parser.add_flag("--tiles-motion", app->tiles.motion, "process tiles with the most motion first");
 	parser.add_flag("-v,--verbose", verbose, "verbose printing");
 	parser.add_flag("--version", version, "print version and exit");
 
@@ -105,6 +126,80 @@ bool Commandline::parse(int argc, char **argv) {
 		app->styleAutoTime = 20;
 	}
 
+	// check image cache
+	if(app->imageCacheSize < 0) {
+		ofLogWarning(PACKAGE) << "ignoring invalid image cache size: " << app->imageCacheSize;
+		app->imageCacheSize = 256;
+	}
+	if(app->imagePrefetch < 0) {
+		ofLogWarning(PACKAGE) << "ignoring invalid image prefetch: " << app->imagePrefetch;
+		app->imagePrefetch = 2;
+	}
+
+	// check hot folder threads
+	if(app->watch.threads < 1) {
+		ofLogWarning(PACKAGE) << "ignoring invalid hot folder threads: " << app->watch.threads;
+		app->watch.threads = 2;
+	}
+
+	// frame pack path, relative to bin/data
+	if(pack != "") {
+		app->packPath = pack;
+		app->packStart = true;
+	}
+
+	// live style requires style camera
+	if(styleLive > 0) {
+		if(app->styleCameraSettings.device < 0) {
+			ofLogWarning(PACKAGE) << "ignoring live style without style camera, use --style-dev";
+		}
+		else {
+			app->styleLive.enabled = true;
+			app->styleLive.rate = styleLive;
+		}
+	}
+	else if(styleLive < 0) {
+		ofLogWarning(PACKAGE) << "ignoring invalid live style rate: " << styleLive;
+	}
+
+	// tracking requires foveated processing
+	if(app->fovea.track) {
+		app->fovea.enabled = true;
+	}
+
+	// tiles: CxR, ie. 2x2 or 4X3
+	if(tiles != "") {
+		std::size_t found = tiles.find_last_of("xX");
+		int cols = (found != std::string::npos ? ofToInt(tiles.substr(0, found)) : 0);
+		int rows = (found != std::string::npos ? ofToInt(tiles.substr(found+1)) : 0);
+		if(cols < 1 || rows < 1) {
+			ofLogWarning(PACKAGE) << "ignoring invalid tiles: " << tiles;
+		}
+		else {
+			app->tiles.cols = cols;
+			app->tiles.rows = rows;
+			app->tiles.enabled = true;
+		}
+	}
+	if(app->tiles.perFrame < 1) {
+		ofLogWarning(PACKAGE) << "ignoring invalid tiles per frame: " << app->tiles.perFrame;
+		app->tiles.perFrame = 1;
+	}
+
+	// camera devices: N or N,N,...
+	if(dev != "") {
+		std::vector<std::string> devices = ofSplitString(dev, ",", true, true);
+		for(std::size_t i = 0; i < devices.size(); ++i) {
+			int device = ofToInt(devices[i]);
+			if(i == 0) {
+				app->cameraSettings.device = device;
+			}
+			else {
+				app->cameraDevices.push_back(device);
+			}
+		}
+	}
+
 	// size: WxH, ie. 640x480 or 1280X720
 	if(size != "") {
 		setCameraSize(app->cameraSettings, size);
@@ -0,0 +1,103 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofConstants.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+
+#ifdef TARGET_LINUX
+	#include <cerrno>
+	#include <cstring>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+// report files added to a directory using inotify
+//
+// a file is reported once it is completely written, ie. closed after writing
+// or moved into the directory, the directory itself is never scanned, so
+// files which exist before open() are ignored
+//
+// linux only
+class FolderWatcher {
+
+	public:
+
+		FolderWatcher() {}
+		FolderWatcher(const FolderWatcher &) = delete;
+		FolderWatcher & operator=(const FolderWatcher &) = delete;
+		virtual ~FolderWatcher() {close();}
+
+		/// watch directory, returns false on error
+		bool open(const std::string & dir) {
+			close();
+		#ifdef TARGET_LINUX
+			path = ofToDataPath(dir, true);
+			fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if(fd < 0 || inotify_add_watch(fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+				ofLogError("FolderWatcher") << "could not watch " << dir << ": " << strerror(errno);
+				close();
+				return false;
+			}
+			return true;
+		#else
+			ofLogError("FolderWatcher") << "folder watching is only supported on linux";
+			return false;
+		#endif
+		}
+
+		void close() {
+		#ifdef TARGET_LINUX
+			if(fd >= 0) {::close(fd);}
+		#endif
+			fd = -1;
+		}
+
+		/// returns true if watching
+		bool isOpen() const {return fd >= 0;}
+
+		/// read pending events without waiting & append absolute paths of
+		/// added files, returns true if any were added
+		bool read(std::vector<std::string> & paths) {
+			bool added = false;
+		#ifdef TARGET_LINUX
+			if(fd < 0) {return false;}
+			while(true) {
+				ssize_t length = ::read(fd, buffer, sizeof(buffer));
+				if(length <= 0) {break;} // EAGAIN: no more events
+				for(ssize_t i = 0; i < length;) {
+					const inotify_event *event = (const inotify_event *)(buffer + i);
+					i += sizeof(inotify_event) + event->len;
+					if(event->mask & IN_Q_OVERFLOW) {
+						ofLogWarning("FolderWatcher") << "event queue overflow, files were missed";
+					}
+					if(event->len > 0 && !(event->mask & IN_ISDIR)) {
+						paths.push_back(ofFilePath::join(path, event->name));
+						added = true;
+					}
+				}
+			}
+		#endif
+			return added;
+		}
+
+	protected:
+
+		int fd = -1; ///< inotify file descriptor
+		std::string path; ///< absolute directory path
+	#ifdef TARGET_LINUX
+		alignas(inotify_event) char buffer[16 * 1024]; ///< event read buffer
+	#endif
+};
@@ -0,0 +1,172 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofFileUtils.h"
+#include "ofLog.h"
+
+#include <cstring>
+#include <sys/stat.h>
+#ifndef TARGET_WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+/// pre-decoded RGB frames in a single memory mapped file,
+/// see scripts/make_framepack.py
+///
+/// frames are used directly from the mapped file, so reading a frame is a
+/// page cache read without decoding or copying
+///
+/// layout, little endian:
+/// * Header
+/// * Entry * count
+/// * frames, each RGB width x height, page aligned
+class FramePack {
+
+	public:
+
+		static const uint32_t VERSION = 1; ///< file format version
+
+		/// file header
+		struct Header {
+			char magic[8]; ///< "STYLPAK"
+			uint32_t version; ///< file format version
+			uint32_t count; ///< number of frames
+			uint32_t width; ///< frame width
+			uint32_t height; ///< frame height
+			uint32_t channels; ///< channels per pixel, always 3
+			uint32_t reserved;
+		};
+
+		/// per frame entry
+		struct Entry {
+			uint64_t offset; ///< frame offset in bytes from file start
+			uint32_t duration; ///< frame playback duration in ms
+			uint32_t reserved;
+		};
+
+		FramePack() {}
+		FramePack(const FramePack &) = delete;
+		FramePack & operator=(const FramePack &) = delete;
+		virtual ~FramePack() {close();}
+
+		/// open and map frame pack file, returns false if missing or invalid
+		bool open(const std::string & path) {
+			close();
+			std::string absPath = ofToDataPath(path, true);
+		#ifdef TARGET_WIN32
+			buffer = ofBufferFromFile(absPath, true);
+			data = buffer.getData();
+			length = buffer.size();
+		#else
+			int fd = ::open(absPath.c_str(), O_RDONLY);
+			if(fd < 0) {
+				ofLogError("FramePack") << "could not open " << path;
+				return false;
+			}
+			struct stat st;
+			if(fstat(fd, &st) == 0 && st.st_size > 0) {
+				void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				if(mapped != MAP_FAILED) {
+					data = (char *)mapped;
+					length = st.st_size;
+				}
+			}
+			::close(fd);
+		#endif
+			if(!validate()) {
+				ofLogError("FramePack") << "invalid frame pack " << path;
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		/// unmap frame pack file, frame data must not be used after
+		void close() {
+		#ifdef TARGET_WIN32
+			buffer.clear();
+		#else
+			if(data) {munmap(data, length);}
+		#endif
+			data = nullptr;
+			length = 0;
+		}
+
+		/// returns true if a frame pack is open
+		bool isOpen() const {return data != nullptr;}
+
+		/// returns number of frames
+		std::size_t size() const {return data ? header()->count : 0;}
+
+		/// returns frame width
+		int getWidth() const {return data ? header()->width : 0;}
+
+		/// returns frame height
+		int getHeight() const {return data ? header()->height : 0;}
+
+		/// returns frame playback duration in ms
+		int getDuration(std::size_t i) const {return entry(i).duration;}
+
+		/// returns mapped RGB frame data
+		unsigned char * getFrame(std::size_t i) const {
+			return (unsigned char *)(data + entry(i).offset);
+		}
+
+		/// hint that a frame will be read soon so it is paged in ahead
+		void willNeed(std::size_t i) const {
+		#ifndef TARGET_WIN32
+			const long page = sysconf(_SC_PAGESIZE);
+			uintptr_t start = (uintptr_t)getFrame(i) & ~(uintptr_t)(page - 1);
+			posix_madvise((void *)start, frameSize() + ((uintptr_t)getFrame(i) - start),
+				POSIX_MADV_WILLNEED);
+		#endif
+		}
+
+	protected:
+
+		const Header * header() const {return (const Header *)data;}
+
+		const Entry & entry(std::size_t i) const {
+			return ((const Entry *)(data + sizeof(Header)))[i];
+		}
+
+		std::size_t frameSize() const {
+			return (std::size_t)header()->width * header()->height * header()->channels;
+		}
+
+		// check header & bounds
+		bool validate() const {
+			if(!data || length < sizeof(Header)) {return false;}
+			const Header *h = header();
+			if(std::strncmp(h->magic, "STYLPAK", sizeof(h->magic)) != 0 ||
+			   h->version != VERSION || h->channels != 3 ||
+			   h->count == 0 || h->width == 0 || h->height == 0 ||
+			   sizeof(Header) + (uint64_t)h->count * sizeof(Entry) > length) {
+				return false;
+			}
+			for(std::size_t i = 0; i < h->count; ++i) {
+				if(entry(i).offset + frameSize() > length) {return false;}
+			}
+			return true;
+		}
+
+		char *data = nullptr; ///< mapped file data
+		std::size_t length = 0; ///< mapped file length
+	#ifdef TARGET_WIN32
+		ofBuffer buffer; ///< file data, no mmap
+	#endif
+};
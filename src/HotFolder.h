@@ -0,0 +1,251 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofTexture.h"
+#include "FolderWatcher.h"
+#include "ImageDecoder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+
+// batch job queue for images dropped into a watched folder
+//
+// new jpg & png files are decoded by a pool of threads, a few ahead of the
+// current image, & shown one at a time in the order they arrived, the result
+// for the current image is written to the output folder with the same file
+// name by the pool, which then takes the next image
+//
+// images which are still being written are not seen, pending results are
+// written before close() returns
+class HotFolder {
+
+	public:
+
+		static const std::size_t AHEAD = 2; ///< images decoded ahead per thread
+
+		HotFolder() {}
+		HotFolder(const HotFolder &) = delete;
+		HotFolder & operator=(const HotFolder &) = delete;
+		virtual ~HotFolder() {close();}
+
+		/// watch input folder & write results to output folder using the given
+		/// number of threads, returns false on error
+		bool open(const std::string & inputDir, const std::string & outputDir,
+		          std::size_t threads=2) {
+			close();
+			if(!watcher.open(inputDir)) {return false;}
+			this->outputDir = ofToDataPath(outputDir, true);
+			ofDirectory::createDirectory(this->outputDir, false, true);
+			stopping = false;
+			for(std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+				workers.emplace_back(new Worker(*this));
+				workers.back()->startThread();
+			}
+			return true;
+		}
+
+		/// stop watching, waits for pending results to be written
+		void close() {
+			watcher.close();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+				condition.notify_all();
+			}
+			for(auto & worker : workers) {
+				worker->waitForThread(false);
+			}
+			workers.clear();
+			jobs.clear();
+			decoded.clear();
+			queued.clear();
+			nextId = presentId = 0;
+			current = nullptr;
+			currentPath = "";
+			busy = newFrame = false;
+			texture.clear();
+		}
+
+		/// returns true if watching
+		bool isOpen() const {return watcher.isOpen();}
+
+		/// decode images to cover width & height, 0 for full size, set before
+		/// files are added
+		void setSize(int width, int height) {
+			size.width = width;
+			size.height = height;
+		}
+
+		/// queue added files, decode ahead, & show the next image once the
+		/// result for the current image has been written
+		void update() {
+			newFrame = false;
+			std::vector<std::string> paths;
+			watcher.read(paths);
+			for(auto & path : paths) {
+				std::string name = ofFilePath::getFileName(path);
+				std::string ext = ofToLower(ofFilePath::getFileExt(path));
+				if(name[0] == '.' || (ext != "jpg" && ext != "jpeg" && ext != "png")) {
+					continue; // hidden, ie. temp, or not an image
+				}
+				queued.push_back(path);
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			while(!queued.empty() && nextId - presentId < workers.size() * AHEAD) {
+				jobs.push_back({Job::DECODE, nextId++, queued.front(), nullptr});
+				queued.pop_front();
+				condition.notify_one();
+			}
+			while(!busy) { // next image in arrival order
+				auto found = decoded.find(presentId);
+				if(found == decoded.end()) {break;}
+				presentId++;
+				if(found->second.pixels) {
+					current = found->second.pixels;
+					currentPath = found->second.path;
+					busy = newFrame = textureDirty = true;
+				}
+				decoded.erase(found); // failed decodes are skipped
+			}
+		}
+
+		/// write result for the current image, pixels are copied, ignored if
+		/// there is no current image or it already has a result
+		void write(const ofPixels & pixels) {
+			if(!busy) {return;}
+			std::string path = ofFilePath::join(outputDir, ofFilePath::getFileName(currentPath));
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back({Job::ENCODE, 0, path, std::make_shared<ofPixels>(pixels)});
+			condition.notify_one();
+			busy = false;
+		}
+
+		/// returns true if the current image is waiting for its result
+		bool isBusy() const {return busy;}
+
+		/// returns number of images waiting, excluding the current image
+		std::size_t getWaiting() const {return queued.size() + (nextId - presentId);}
+
+		void draw(float x, float y, float w, float h) {
+			if(!current) {return;}
+			if(textureDirty) {
+				texture.loadData(*current);
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		float getWidth() const {return current ? current->getWidth() : 0;}
+		float getHeight() const {return current ? current->getHeight() : 0;}
+
+		const ofPixels & getPixels() const {
+			static const ofPixels empty;
+			return current ? *current : empty;
+		}
+
+	protected:
+
+		/// decode or encode job
+		struct Job {
+			enum Type {
+				DECODE, ///< decode path into pixels
+				ENCODE ///< write pixels to path
+			} type;
+			uint64_t id; ///< decode arrival order
+			std::string path; ///< input or output path
+			std::shared_ptr<ofPixels> pixels; ///< encode only
+		};
+
+		/// decoded image, pixels are null on error
+		struct Decoded {
+			std::string path;
+			std::shared_ptr<ofPixels> pixels;
+		};
+
+		/// pool thread
+		class Worker : public ofThread {
+			public:
+				Worker(HotFolder & folder) : folder(folder) {}
+			protected:
+				void threadedFunction() {folder.work();}
+				HotFolder & folder; ///< job queue owner
+		};
+
+		// run jobs until stopped, results are still written when stopping
+		void work() {
+			while(true) {
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [this] {return !jobs.empty() || stopping;});
+					if(stopping) { // drop decodes, finish writing
+						auto encode = std::find_if(jobs.begin(), jobs.end(),
+							[](const Job & job) {return job.type == Job::ENCODE;});
+						if(encode == jobs.end()) {return;}
+						job = std::move(*encode);
+						jobs.erase(encode);
+					}
+					else {
+						job = std::move(jobs.front());
+						jobs.pop_front();
+					}
+				}
+				if(job.type == Job::DECODE) {
+					auto pixels = std::make_shared<ofPixels>();
+					bool loaded = (size.width > 0 && size.height > 0 ?
+					               ImageDecoder::loadResized(*pixels, job.path, size.width, size.height) :
+					               ImageDecoder::load(*pixels, job.path));
+					std::lock_guard<std::mutex> lock(mutex);
+					decoded[job.id] = {job.path, loaded ? pixels : nullptr};
+				}
+				else {
+					if(ofSaveImage(*job.pixels, job.path)) {
+						ofLogVerbose("HotFolder") << "wrote " << job.path;
+					}
+					else {
+						ofLogWarning("HotFolder") << "could not write " << job.path;
+					}
+				}
+			}
+		}
+
+		FolderWatcher watcher; ///< input folder events
+		std::string outputDir; ///< absolute output folder path
+		std::vector<std::unique_ptr<Worker>> workers; ///< thread pool
+
+		std::mutex mutex; ///< guards jobs, decoded, & stopping
+		std::condition_variable condition; ///< signals jobs or stopping
+		std::deque<Job> jobs; ///< main -> pool
+		std::map<uint64_t, Decoded> decoded; ///< pool -> main, by arrival order
+		bool stopping = false; ///< stop pool once results are written?
+
+		std::deque<std::string> queued; ///< added paths not yet decoding
+		uint64_t nextId = 0; ///< next decode arrival order
+		uint64_t presentId = 0; ///< next arrival order to show
+		std::shared_ptr<ofPixels> current; ///< current image
+		std::string currentPath; ///< current image input path
+		ofTexture texture; ///< current image texture, uploaded on draw
+		struct {
+			int width = 0;
+			int height = 0;
+		} size; ///< decode size, 0 for full size
+		bool busy = false; ///< is the current image waiting for its result?
+		bool newFrame = false; ///< is the current image new?
+		bool textureDirty = false; ///< does the texture need an upload?
+};
@@ -0,0 +1,205 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ImageDecoder.h"
+
+#include <condition_variable>
+#include <list>
+
+/// decoded image cache for a playlist of image paths
+///
+/// the images around the current index are decoded ahead of time on a
+/// background thread, decoded images are kept least recently used first
+/// within a byte budget
+class ImageCache : public ofThread {
+
+	public:
+
+		virtual ~ImageCache() {
+			clear();
+		}
+
+		/// set image paths & start prefetching
+		void setup(const std::vector<std::string> & paths) {
+			clear();
+			std::lock_guard<std::mutex> lock(mutex);
+			this->paths = paths;
+			index = 0;
+			startThread();
+		}
+
+		/// stop prefetching & free decoded images
+		void clear() {
+			stopThread();
+			{
+				std::lock_guard<std::mutex> lock(mutex); // don't miss the wake up
+				condition.notify_all();
+			}
+			waitForThread(false);
+			std::lock_guard<std::mutex> lock(mutex);
+			paths.clear();
+			entries.clear();
+			bytes = 0;
+		}
+
+		/// set max decoded bytes to keep, the current & prefetched images
+		/// are kept even if over budget
+		void setBudget(std::size_t bytes) {
+			std::lock_guard<std::mutex> lock(mutex);
+			budget = bytes;
+			evict();
+		}
+
+		/// set decoded image size, images are downscaled on decode & resampled
+		/// to this size, 0 for full size
+		void setSize(int width, int height) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(width == this->width && height == this->height) {return;}
+			this->width = width;
+			this->height = height;
+			entries.clear();
+			bytes = 0;
+			condition.notify_all();
+		}
+
+		/// returns max decoded bytes to keep
+		std::size_t getBudget() const {return budget;}
+
+		/// set number of images to prefetch before & after the current index
+		void setPrefetch(int count) {
+			std::lock_guard<std::mutex> lock(mutex);
+			prefetch = std::max(count, 0);
+			condition.notify_all();
+		}
+
+		/// set current index, prefetching moves around it
+		void setIndex(std::size_t index) {
+			std::lock_guard<std::mutex> lock(mutex);
+			this->index = index;
+			condition.notify_all();
+		}
+
+		/// get decoded RGB image pixels, pixels are nullptr if the image could
+		/// not be loaded, returns false if not decoded yet
+		bool get(std::size_t index, std::shared_ptr<const ofPixels> & pixels) {
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = find(index);
+			if(found == entries.end()) {return false;}
+			entries.splice(entries.begin(), entries, found); // most recently used
+			pixels = found->pixels;
+			return true;
+		}
+
+		/// decode RGB image now at size or full size if 0, does not use the
+		/// cache, returns nullptr on error
+		static std::shared_ptr<ofPixels> decode(const std::string & path, int width=0, int height=0) {
+			auto pixels = std::make_shared<ofPixels>();
+			bool loaded = (width > 0 && height > 0 ?
+			               ImageDecoder::loadResized(*pixels, path, width, height) :
+			               ImageDecoder::load(*pixels, path));
+			return (loaded ? pixels : nullptr);
+		}
+
+	protected:
+
+		/// decoded image
+		struct Entry {
+			std::size_t index; ///< path index
+			std::shared_ptr<const ofPixels> pixels; ///< decoded pixels, nullptr on error
+		};
+
+		void threadedFunction() {
+			while(isThreadRunning()) {
+				std::size_t next;
+				std::string path;
+				int w, h;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [this, &next] {
+						return !isThreadRunning() || wanted(next);
+					});
+					if(!isThreadRunning()) {break;}
+					path = paths[next];
+					w = width;
+					h = height;
+				}
+				auto pixels = decode(path, w, h);
+				std::lock_guard<std::mutex> lock(mutex);
+				if(next < paths.size() && find(next) == entries.end() &&
+				   w == width && h == height) {
+					entries.push_front({next, pixels});
+					bytes += size(pixels);
+					evict();
+				}
+			}
+		}
+
+		// find the nearest image around index which is not decoded yet,
+		// current first, then next & previous alternating
+		bool wanted(std::size_t & next) {
+			if(paths.empty()) {return false;}
+			int count = std::min((int)paths.size(), 1 + prefetch * 2);
+			for(int i = 0; i < count; ++i) {
+				int offset = (i + 1) / 2 * (i % 2 ? 1 : -1);
+				next = wrap(offset);
+				if(find(next) == entries.end()) {return true;}
+			}
+			return false;
+		}
+
+		// remove least recently used images over budget, keeps window
+		void evict() {
+			for(auto it = entries.end(); bytes > budget && it != entries.begin();) {
+				--it;
+				if(inWindow(it->index)) {continue;}
+				bytes -= size(it->pixels);
+				it = entries.erase(it);
+			}
+		}
+
+		// is path index within the prefetch window around the current index?
+		bool inWindow(std::size_t i) {
+			for(int offset = -prefetch; offset <= prefetch; ++offset) {
+				if(wrap(offset) == i) {return true;}
+			}
+			return false;
+		}
+
+		// current index + offset wrapped to the paths size
+		std::size_t wrap(int offset) {
+			int n = paths.size();
+			return ((int)index + offset % n + n) % n;
+		}
+
+		std::list<Entry>::iterator find(std::size_t index) {
+			return std::find_if(entries.begin(), entries.end(),
+				[index](const Entry & e) {return e.index == index;});
+		}
+
+		static std::size_t size(const std::shared_ptr<const ofPixels> & pixels) {
+			return (pixels ? pixels->size() : 0);
+		}
+
+		std::vector<std::string> paths; ///< image paths
+		std::size_t index = 0; ///< current path index
+		int width = 0; ///< decoded width, 0 for full size
+		int height = 0; ///< decoded height, 0 for full size
+		int prefetch = 2; ///< images to prefetch before & after index
+		std::size_t budget = 256 * 1024 * 1024; ///< max decoded bytes
+		std::size_t bytes = 0; ///< current decoded bytes
+		std::list<Entry> entries; ///< decoded images, most recently used first
+		std::condition_variable condition; ///< wakes the thread to prefetch
+};
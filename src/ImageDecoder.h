@@ -0,0 +1,126 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofImage.h"
+#include "FreeImage.h"
+
+#include <mutex>
+
+/// RGB image decoding with downscale-on-decode
+///
+/// JPEGs are decoded by libjpeg at the smallest 1/2, 1/4, or 1/8 DCT scale
+/// which still covers the requested min size, so large photos are never
+/// decoded at full resolution, other formats are decoded as usual
+///
+/// safe to call from any thread
+class ImageDecoder {
+
+	public:
+
+		/// decode image file into RGB pixels which cover min width & height,
+		/// keeps aspect ratio, 0 for full size, returns false on error
+		static bool load(ofPixels & pixels, const std::string & path,
+		                 int minWidth=0, int minHeight=0) {
+			ofBuffer buffer = ofBufferFromFile(path, true);
+			if(buffer.size() == 0) {
+				ofLogWarning("ImageDecoder") << "could not load " << path;
+				return false;
+			}
+			if(!load(pixels, buffer, minWidth, minHeight)) {
+				ofLogWarning("ImageDecoder") << "could not load " << path;
+				return false;
+			}
+			return true;
+		}
+
+		/// decode image file data into RGB pixels which cover min width &
+		/// height, keeps aspect ratio, 0 for full size, returns false on error
+		static bool load(ofPixels & pixels, const ofBuffer & buffer,
+		                 int minWidth=0, int minHeight=0) {
+			static std::once_flag initialized;
+			std::call_once(initialized, [] {FreeImage_Initialise();});
+
+			FIMEMORY *memory = FreeImage_OpenMemory((BYTE *)buffer.getData(), buffer.size());
+			FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(memory, 0);
+			if(format != FIF_JPEG || (minWidth <= 0 && minHeight <= 0)) {
+				FreeImage_CloseMemory(memory);
+				return loadRGB(pixels, buffer);
+			}
+
+			// requested size is the longer side, from header only
+			int requested = 0;
+			FIBITMAP *header = FreeImage_LoadFromMemory(format, memory, FIF_LOAD_NOPIXELS);
+			if(header) {
+				float w = FreeImage_GetWidth(header), h = FreeImage_GetHeight(header);
+				float scale = std::max(minWidth / w, minHeight / h);
+				requested = (scale < 1 ? ceil(std::max(w, h) * scale) : 0);
+				FreeImage_Unload(header);
+			}
+			if(requested == 0) { // small enough or unknown
+				FreeImage_CloseMemory(memory);
+				return loadRGB(pixels, buffer);
+			}
+
+			// libjpeg DCT scaling, may be larger than requested
+			FreeImage_SeekMemory(memory, 0, SEEK_SET);
+			FIBITMAP *bitmap = FreeImage_LoadFromMemory(format, memory, requested << 16);
+			FreeImage_CloseMemory(memory);
+			if(!bitmap) {return false;}
+			bool loaded = bitmapToPixels(bitmap, pixels);
+			FreeImage_Unload(bitmap);
+			return loaded;
+		}
+
+		/// decode & resample to exact width & height, ignores aspect ratio
+		/// to match model input resizing, returns false on error
+		static bool loadResized(ofPixels & pixels, const std::string & path, int width, int height) {
+			if(!load(pixels, path, width, height)) {return false;}
+			if((int)pixels.getWidth() != width || (int)pixels.getHeight() != height) {
+				ofPixels resized;
+				resized.allocate(width, height, OF_PIXELS_RGB);
+				pixels.resizeTo(resized, OF_INTERPOLATE_BILINEAR);
+				pixels = std::move(resized);
+			}
+			return true;
+		}
+
+	protected:
+
+		// full size decode via openFrameworks, converted to RGB
+		static bool loadRGB(ofPixels & pixels, const ofBuffer & buffer) {
+			if(!ofLoadImage(pixels, buffer)) {return false;}
+			if(pixels.getImageType() != OF_IMAGE_COLOR) {
+				// model requires RGB without alpha
+				pixels.setImageType(OF_IMAGE_COLOR);
+			}
+			return true;
+		}
+
+		// copy 8 bit bitmap into RGB pixels
+		static bool bitmapToPixels(FIBITMAP *bitmap, ofPixels & pixels) {
+			if(FreeImage_GetImageType(bitmap) != FIT_BITMAP) {return false;}
+			FIBITMAP *rgb = FreeImage_ConvertTo24Bits(bitmap);
+			if(!rgb) {return false;}
+			int w = FreeImage_GetWidth(rgb), h = FreeImage_GetHeight(rgb);
+			pixels.allocate(w, h, OF_PIXELS_RGB);
+			FreeImage_ConvertToRawBits(pixels.getData(), rgb, w * 3, 24,
+				FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, TRUE); // top down
+			FreeImage_Unload(rgb);
+		#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_BGR
+			pixels.swapRgb();
+		#endif
+			return true;
+		}
+};
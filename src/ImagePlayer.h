@@ -15,8 +15,12 @@
 
 #include "ofBaseTypes.h"
 #include "ofUtils.h"
+#include "ImageCache.h"
 
 // mimic ofVideoPlayer but just show still images
+//
+// images are decoded ahead of time in the background, a frame change is
+// shown once its image is decoded & the previous image is kept until then
 class ImagePlayer {
 
 	public:
@@ -24,16 +28,27 @@ class ImagePlayer {
 		bool load(const std::vector<std::string> & paths) {
 			if(paths.empty()) {return false;}
 			this->paths = paths;
-			setImage(this->paths[index]);
+			if(index >= paths.size()) {index = 0;}
+			cache.setup(paths);
+			setImage(index);
 			return true;
 		}
 
 		void close() {
 			stop();
+			cache.clear();
 			image.clear();
+			pending = false;
 		}
 
 		void update() {
+			if(pending) { // requested image decoded?
+				std::shared_ptr<const ofPixels> pixels;
+				if(cache.get(index, pixels)) {
+					if(pixels) {setPixels(*pixels);}
+					pending = false;
+				}
+			}
 			if(playing && !paused) { // auto advance frame?
 				if(ofGetElapsedTimeMillis() - timestamp >= frameTime) {
 					nextFrame();
@@ -69,7 +84,7 @@ class ImagePlayer {
 		void play() {
 			if(index != 0) {
 				index = 0;
-				setImage(this->paths[index]);
+				setImage(index);
 			}
 			timestamp = ofGetElapsedTimeMillis();
 			paused = false;
@@ -90,7 +105,7 @@ class ImagePlayer {
 			else {
 				index--;
 			}
-			setImage(paths[index]);
+			setImage(index);
 		}
 
 		void nextFrame() {
@@ -98,9 +113,18 @@ class ImagePlayer {
 			if(index >= paths.size()) {
 				index = 0;
 			}
-			setImage(paths[index]);
+			setImage(index);
 		}
 
+		/// set image size, images are downscaled on decode, 0 for full size
+		void setSize(int width, int height) {cache.setSize(width, height);}
+
+		/// set max bytes of decoded images to keep
+		void setCacheSize(std::size_t bytes) {cache.setBudget(bytes);}
+
+		/// set number of images to decode ahead before & after the current
+		void setPrefetch(int count) {cache.setPrefetch(count);}
+
 		void setFrameTime(int ms) {frameTime = ms;}
 		int getFrameTime() {return frameTime;}
 
@@ -113,20 +137,30 @@ class ImagePlayer {
 
 	protected:
 
-		void setImage(std::string & path) {
-			if(!image.load(path)) {
-				return;
+		// show image by path index if decoded, otherwise in update() when ready
+		void setImage(std::size_t index) {
+			cache.setIndex(index);
+			std::shared_ptr<const ofPixels> pixels;
+			if(cache.get(index, pixels)) {
+				if(pixels) {setPixels(*pixels);}
+				pending = false;
 			}
-			if(image.getImageType() != OF_IMAGE_COLOR) {
-				// model requires RGB without alpha, this is expensive
-				image.setImageType(OF_IMAGE_COLOR);
+			else {
+				pending = true;
 			}
+		}
+
+		// set decoded RGB pixels as current image
+		void setPixels(const ofPixels & pixels) {
+			image.setFromPixels(pixels);
 			frameSet = true; // signal new frame in update()
 		}
 
 	    std::vector<std::string> paths; ///< image file paths, min 1 required
 		std::size_t index = 0; ///< image path index
 		ofImage image; ///< current image
+		ImageCache cache; ///< decoded images, prefetched around index
+		bool pending = false; ///< waiting for image at index to be decoded?
 		bool newFrame = false; ///< outward frame change indicator
 		bool frameSet = false; ///< inward frame change indicator
 		bool playing = false; ///< is playback enabled?
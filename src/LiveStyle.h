@@ -0,0 +1,105 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofThreadChannel.h"
+#include "StyleCache.h"
+
+/// continuous style from a live source at a throttled rate
+///
+/// frames are taken at most at the given rate & prepared on a background
+/// thread: center square crop downsampled to model style size, the content
+/// pipeline only swaps in the finished style
+class LiveStyle : public ofThread {
+
+	public:
+
+		virtual ~LiveStyle() {
+			stop();
+		}
+
+		/// set style update rate in Hz
+		void setRate(float rate) {
+			this->rate = std::max(rate, 0.01f);
+		}
+
+		/// returns style update rate in Hz
+		float getRate() const {return rate;}
+
+		/// start preparing styles in the background
+		void start() {
+			if(isThreadRunning()) {return;}
+			toProcess = std::make_shared<ofThreadChannel<ofPixels>>();
+			processed = std::make_shared<ofThreadChannel<std::shared_ptr<Style>>>();
+			busy = false;
+			timestamp = 0;
+			startThread();
+		}
+
+		/// stop preparing styles
+		void stop() {
+			if(!isThreadRunning()) {return;}
+			stopThread();
+			toProcess->close();
+			processed->close();
+			waitForThread(false);
+		}
+
+		/// returns true if running
+		bool isEnabled() const {return isThreadRunning();}
+
+		/// offer a new source frame, taken if due & the previous style is done
+		/// returns true if the frame was taken
+		bool update(const ofPixels & pixels) {
+			if(!isThreadRunning() || busy || !pixels.isAllocated()) {return false;}
+			float now = ofGetElapsedTimef();
+			if(now - timestamp < 1.0 / rate) {return false;}
+			timestamp = now;
+			busy = true;
+			toProcess->send(pixels);
+			return true;
+		}
+
+		/// receive the latest prepared style, returns false if none is new
+		bool receive(std::shared_ptr<Style> & style) {
+			if(!isThreadRunning()) {return false;}
+			bool received = false;
+			while(processed->tryReceive(style)) {
+				received = true;
+			}
+			return received;
+		}
+
+	protected:
+
+		void threadedFunction() {
+			ofPixels pixels;
+			while(toProcess->receive(pixels)) {
+				// center square crop, style images are square
+				int s = std::min(pixels.getWidth(), pixels.getHeight());
+				pixels.crop((pixels.getWidth() - s) / 2, (pixels.getHeight() - s) / 2, s, s);
+				auto style = StyleCache::fromPixels(pixels);
+				busy = false;
+				processed->send(std::move(style));
+			}
+		}
+
+		float rate = 2; ///< update rate in Hz
+		float timestamp = 0; ///< last frame timestamp in s
+		std::atomic<bool> busy {false}; ///< preparing a style?
+
+		std::shared_ptr<ofThreadChannel<ofPixels>> toProcess; ///< source frames
+		std::shared_ptr<ofThreadChannel<std::shared_ptr<Style>>> processed; ///< prepared styles
+};
@@ -0,0 +1,169 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofThreadChannel.h"
+#include "ImageDecoder.h"
+#include "SpscQueue.h"
+
+// MJPEG camera frames decoded by a small pool of threads
+//
+// compressed frames are copied into recycled job buffers & handed to an idle
+// decoder thread, each decodes at the smallest DCT scale which covers the
+// decode size & mirrors, decoded frames are taken in sequence order: a frame
+// which finishes after a newer one is dropped, frames submitted while all
+// threads are busy are dropped so the camera stays live
+//
+// the main thread submits & takes frames, nothing blocks it
+class MjpegDecoder {
+
+	public:
+
+		MjpegDecoder() {}
+		MjpegDecoder(const MjpegDecoder &) = delete;
+		MjpegDecoder & operator=(const MjpegDecoder &) = delete;
+		virtual ~MjpegDecoder() {close();}
+
+		/// start decoder threads, frames cover min width & height keeping
+		/// aspect ratio, 0 for full size
+		void setup(std::size_t threads, int minWidth=0, int minHeight=0) {
+			close();
+			decodeSize.width = minWidth;
+			decodeSize.height = minHeight;
+			pool.resize(std::max<std::size_t>(threads, 1) + 1); // + current
+			for(auto & job : pool) {
+				free.push_back(&job);
+			}
+			for(std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+				workers.emplace_back(new Worker(*this));
+				workers.back()->startThread();
+			}
+		}
+
+		/// stop decoder threads & release buffers
+		void close() {
+			for(auto & worker : workers) {
+				worker->stopThread();
+				worker->jobs.close();
+			}
+			for(auto & worker : workers) {
+				worker->waitForThread(false);
+			}
+			workers.clear();
+			free.clear();
+			pool.clear();
+			current = nullptr;
+			newFrame = false;
+		}
+
+		/// mirror decoded frames, applies to frames submitted after
+		void setMirror(bool horz, bool vert) {
+			mirror.horz = horz;
+			mirror.vert = vert;
+		}
+
+		/// submit compressed frame, data is copied, sequence must increase,
+		/// returns false if all decoder threads are busy & the frame is dropped
+		bool submit(const uint8_t *data, std::size_t size, uint64_t sequence) {
+			for(auto & worker : workers) {
+				if(worker->pending || free.empty()) {continue;}
+				Job *job = free.back();
+				free.pop_back();
+				job->buffer.set((const char *)data, size); // keeps capacity
+				job->sequence = sequence;
+				job->mirror = mirror;
+				worker->pending = true;
+				worker->jobs.send(job);
+				return true;
+			}
+			return false;
+		}
+
+		/// take the newest decoded frame, older ones are dropped
+		void update() {
+			newFrame = false;
+			for(auto & worker : workers) {
+				Job *job;
+				if(!worker->done.pop(job)) {continue;}
+				worker->pending = false;
+				if(job->decoded && (!current || job->sequence > current->sequence)) {
+					if(current) {free.push_back(current);}
+					current = job;
+					newFrame = true;
+				}
+				else {
+					free.push_back(job); // failed or out of order
+				}
+			}
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		/// current decoded RGB frame
+		const ofPixels & getPixels() const {
+			static const ofPixels empty;
+			return current ? current->pixels : empty;
+		}
+
+	protected:
+
+		/// mirror flags
+		struct Mirror {
+			bool horz = false;
+			bool vert = false;
+		};
+
+		/// decode job, owned by main unless sent to a worker
+		struct Job {
+			ofBuffer buffer; ///< compressed frame
+			ofPixels pixels; ///< decoded frame
+			uint64_t sequence = 0; ///< camera frame sequence
+			Mirror mirror; ///< mirror after decoding
+			bool decoded = false; ///< was decoding successful?
+		};
+
+		/// decoder thread, takes one job at a time
+		class Worker : public ofThread {
+			public:
+				Worker(MjpegDecoder & decoder) : decoder(decoder) {}
+				ofThreadChannel<Job *> jobs; ///< main -> worker
+				SpscQueue<Job *, 1> done; ///< worker -> main
+				bool pending = false; ///< is a job sent & not done? main only
+			protected:
+				void threadedFunction() {
+					Job *job;
+					while(jobs.receive(job)) { // waits, false when closed
+						job->decoded = ImageDecoder::load(job->pixels, job->buffer,
+							decoder.decodeSize.width, decoder.decodeSize.height);
+						if(job->decoded && (job->mirror.horz || job->mirror.vert)) {
+							job->pixels.mirror(job->mirror.vert, job->mirror.horz);
+						}
+						done.push(job); // never full, one job at a time
+					}
+				}
+				MjpegDecoder & decoder; ///< owner, decode size
+		};
+
+		std::vector<Job> pool; ///< jobs, sized on setup
+		std::vector<Job *> free; ///< unused jobs, main only
+		std::vector<std::unique_ptr<Worker>> workers; ///< decoder threads
+		Job *current = nullptr; ///< current frame, held by main
+		struct {
+			int width = 0;
+			int height = 0;
+		} decodeSize; ///< min decode size, 0 for full size
+		Mirror mirror; ///< mirror for submitted frames
+		bool newFrame = false; ///< is the current frame new?
+};
@@ -0,0 +1,133 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofPixels.h"
+#include "ofRectangle.h"
+
+/// simple frame differencing motion detector
+///
+/// frames are sampled into a small grayscale grid which is compared to the
+/// previous frame, so the cost is independent of the input size
+class MotionDetector {
+
+	public:
+
+		/// set grid width in cells, height follows the input aspect ratio
+		void setGridWidth(int width) {
+			gridWidth = std::max(width, 1);
+			grid.clear();
+		}
+
+		/// set per cell difference threshold, 0-255
+		void setThreshold(int threshold) {this->threshold = threshold;}
+
+		/// update with new frame pixels, RGB or grayscale
+		void update(const ofPixels & pixels) {
+			if(!pixels.isAllocated()) {return;}
+			int w = gridWidth;
+			int h = std::max((int)(w * pixels.getHeight() / pixels.getWidth()), 1);
+			if(w != (int)grid.getWidth() || h != (int)grid.getHeight()) {
+				grid.allocate(w, h, OF_PIXELS_GRAY);
+				previous.allocate(w, h, OF_PIXELS_GRAY);
+				diff.allocate(w, h, OF_PIXELS_GRAY);
+				sample(pixels, previous);
+				diff.set(0);
+				motion = 0;
+				return;
+			}
+			sample(pixels, grid);
+
+			// difference & weighted centroid
+			float sum = 0, sx = 0, sy = 0;
+			for(int y = 0; y < h; ++y) {
+				for(int x = 0; x < w; ++x) {
+					int i = y * w + x;
+					int d = std::abs(grid[i] - previous[i]);
+					diff[i] = (d > threshold ? d : 0);
+					if(diff[i] > 0) {
+						sum += d;
+						sx += d * (x + 0.5f);
+						sy += d * (y + 0.5f);
+					}
+				}
+			}
+			std::swap(grid, previous);
+			motion = sum / (255.f * w * h);
+			if(sum > 0) {
+				centroid.x = sx / sum / w;
+				centroid.y = sy / sum / h;
+			}
+		}
+
+		/// returns true if any motion was detected in the last update
+		bool hasMotion() const {return motion > 0;}
+
+		/// returns motion amount over the whole frame, 0-1
+		float getMotion() const {return motion;}
+
+		/// returns motion amount within a normalized rect, 0-1
+		float getMotion(const ofRectangle & rect) const {
+			if(!diff.isAllocated()) {return 0;}
+			int w = diff.getWidth(), h = diff.getHeight();
+			int x0 = ofClamp(rect.x * w, 0, w), x1 = ofClamp(ceil((rect.x + rect.width) * w), 0, w);
+			int y0 = ofClamp(rect.y * h, 0, h), y1 = ofClamp(ceil((rect.y + rect.height) * h), 0, h);
+			if(x1 <= x0 || y1 <= y0) {return 0;}
+			float sum = 0;
+			for(int y = y0; y < y1; ++y) {
+				for(int x = x0; x < x1; ++x) {
+					sum += diff[y * w + x];
+				}
+			}
+			return sum / (255.f * (x1 - x0) * (y1 - y0));
+		}
+
+		/// returns normalized motion centroid, last known position if no motion
+		const glm::vec2 & getCentroid() const {return centroid;}
+
+		/// reset previous frame & centroid
+		void clear() {
+			grid.clear();
+			previous.clear();
+			diff.clear();
+			motion = 0;
+			centroid = {0.5, 0.5};
+		}
+
+	protected:
+
+		// sample source pixels into grayscale grid pixels using cell centers
+		void sample(const ofPixels & src, ofPixels & dst) {
+			int w = dst.getWidth(), h = dst.getHeight();
+			int sw = src.getWidth(), sh = src.getHeight();
+			int channels = src.getNumChannels();
+			const unsigned char *data = src.getData();
+			for(int y = 0; y < h; ++y) {
+				int sy = (int)((y + 0.5f) * sh / h);
+				for(int x = 0; x < w; ++x) {
+					int sx = (int)((x + 0.5f) * sw / w);
+					const unsigned char *p = data + (sy * sw + sx) * channels;
+					dst[y * w + x] = (channels >= 3 ? (p[0] + 2 * p[1] + p[2]) / 4 : p[0]);
+				}
+			}
+		}
+
+		int gridWidth = 64; ///< grid width in cells
+		int threshold = 24; ///< per cell difference threshold
+		ofPixels grid; ///< current sampled frame
+		ofPixels previous; ///< previous sampled frame
+		ofPixels diff; ///< thresholded difference
+		float motion = 0; ///< motion amount, 0-1
+		glm::vec2 centroid = {0.5, 0.5}; ///< normalized motion centroid
+};
@@ -0,0 +1,148 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofTexture.h"
+#include "ofUtils.h"
+#include "FramePack.h"
+
+// mimic ofVideoPlayer but play pre-decoded frames from a frame pack
+//
+// pixels point into the mapped pack, so a frame change is neither a decode
+// nor a copy, the texture is only uploaded when the frame is drawn
+class PackPlayer {
+
+	public:
+
+		bool load(const std::string & path) {
+			close();
+			if(!pack.open(path)) {return false;}
+			index = 0;
+			setFrame(index);
+			return true;
+		}
+
+		void close() {
+			stop();
+			pixels.clear();
+			texture.clear();
+			pack.close();
+			textureDirty = false;
+		}
+
+		void update() {
+			if(playing && !paused && pack.isOpen()) { // auto advance frame?
+				if(ofGetElapsedTimeMillis() - timestamp >= (uint64_t)pack.getDuration(index)) {
+					nextFrame();
+					timestamp = ofGetElapsedTimeMillis();
+				}
+			}
+			if(frameSet) { // new frame
+				newFrame = true;
+				frameSet = false;
+			}
+			else { // nothing to do
+				newFrame = false;
+			}
+		}
+
+		void draw(float x, float y) {
+			draw(x, y, getWidth(), getHeight());
+		}
+
+		void draw(float x, float y, float w, float h) {
+			if(!pixels.isAllocated()) {return;}
+			if(textureDirty) {
+				texture.loadData(pixels);
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		void setPaused(bool paused) {
+			if(playing && (this->paused && !paused)) {
+				timestamp = ofGetElapsedTimeMillis();
+			}
+			this->paused = paused;
+		}
+		bool isPaused() const {return paused;}
+		void play() {
+			if(index != 0) {
+				index = 0;
+				setFrame(index);
+			}
+			timestamp = ofGetElapsedTimeMillis();
+			paused = false;
+			playing = true;
+		}
+		void stop() {
+			playing = false;
+			paused = false;
+		}
+
+		bool isLoaded() const {return pack.isOpen();}
+		bool isPlaying() const {return playing;}
+
+		void previousFrame() {
+			if(!pack.isOpen()) {return;}
+			if(index == 0) {
+				index = pack.size()-1;
+			}
+			else {
+				index--;
+			}
+			setFrame(index);
+		}
+
+		void nextFrame() {
+			if(!pack.isOpen()) {return;}
+			index++;
+			if(index >= pack.size()) {
+				index = 0;
+			}
+			setFrame(index);
+		}
+
+		float getWidth() const {return pack.getWidth();}
+		float getHeight() const {return pack.getHeight();}
+
+		const ofPixels & getPixels() const {return pixels;}
+
+		bool isLastFrame() {return index == pack.size()-1;}
+
+	protected:
+
+		// point pixels at frame in the mapped pack
+		void setFrame(std::size_t index) {
+			if(!pack.isOpen()) {return;}
+			pixels.setFromExternalPixels(pack.getFrame(index),
+				pack.getWidth(), pack.getHeight(), OF_PIXELS_RGB);
+			pack.willNeed((index + 1) % pack.size()); // page in next ahead
+			textureDirty = true;
+			frameSet = true; // signal new frame in update()
+		}
+
+		FramePack pack; ///< mapped frames
+		std::size_t index = 0; ///< frame index
+		ofPixels pixels; ///< current frame, aliases mapped data
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		bool textureDirty = false; ///< does the texture need an upload?
+		bool newFrame = false; ///< outward frame change indicator
+		bool frameSet = false; ///< inward frame change indicator
+		bool playing = false; ///< is playback enabled?
+		bool paused = false; ///< is playback paused?
+		long timestamp = 0; ///< playback timestamp
+};
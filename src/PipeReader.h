@@ -0,0 +1,342 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofTexture.h"
+#include "SpscQueue.h"
+#include "Yuv.h"
+
+#include <cerrno>
+#include <cstring>
+#ifndef TARGET_WIN32
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+// read a stream of raw frames from stdin or a named pipe (FIFO)
+//
+// YUV4MPEG2 (y4m) streams are detected by their header & converted to RGB,
+// otherwise frames are raw RGB of a declared size, ie. from ffmpeg:
+//
+//     ffmpeg -i in.mp4 -f yuv4mpegpipe - | Styler --input -
+//     ffmpeg -i in.mp4 -f rawvideo -pix_fmt rgb24 -s 640x480 /tmp/styler
+//
+// frames are read on a background thread with large reads straight into a
+// fixed pool of recycled frame buffers, frames which arrive while all buffers
+// are in use are read & dropped so the stream stays live
+//
+// a named pipe is held open for writing as well, so the stream waits for a
+// writer to connect or reconnect instead of ending, a restarted y4m writer's
+// new header is detected between frames
+//
+// the texture is only uploaded when the frame is drawn, not on windows
+class PipeReader : public ofThread {
+
+	public:
+
+		static const std::size_t POOL_SIZE = 4; ///< number of frame buffers
+		static const std::size_t BUFFER_SIZE = 64 * 1024; ///< header read buffer
+
+		PipeReader() {
+			reset();
+		}
+
+		virtual ~PipeReader() {
+			close();
+		}
+
+		/// open stdin for "-" or a named pipe path & start reading, width &
+		/// height are the raw RGB frame size, ignored for y4m streams
+		bool open(const std::string & path, int width, int height) {
+		#ifdef TARGET_WIN32
+			ofLogError("PipeReader") << "pipe input not supported on windows";
+			return false;
+		#else
+			close();
+			if(path == "-") {
+				fd = dup(STDIN_FILENO); // left blocking, shared with parent
+			}
+			else {
+				// own write end: no EOF without a writer & open does not block
+				fd = ::open(ofToDataPath(path, true).c_str(), O_RDWR);
+			}
+			if(fd < 0) {
+				ofLogError("PipeReader") << "could not open " << path;
+				return false;
+			}
+			this->path = path;
+			rawSize.width = width;
+			rawSize.height = height;
+			startThread();
+			return true;
+		#endif
+		}
+
+		void close() {
+			stopThread();
+			waitForThread(false); // reads time out to check for stop
+		#ifndef TARGET_WIN32
+			if(fd >= 0) {::close(fd);}
+		#endif
+			fd = -1;
+			reset();
+			texture.clear();
+		}
+
+		/// show the latest frame, drops older frames
+		void update() {
+			newFrame = false;
+			ofPixels *pixels;
+			while(frames.pop(pixels)) {
+				if(paused) {free.push(pixels); continue;}
+				if(current) {free.push(current);}
+				current = pixels;
+				textureDirty = true;
+				newFrame = true;
+			}
+		}
+
+		void draw(float x, float y) {
+			draw(x, y, getWidth(), getHeight());
+		}
+
+		void draw(float x, float y, float w, float h) {
+			if(!current) {return;}
+			if(textureDirty) {
+				texture.loadData(*current);
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		/// pause by dropping new frames, the stream keeps being read
+		void setPaused(bool paused) {this->paused = paused;}
+		bool isPaused() const {return paused;}
+
+		float getWidth() const {return current ? current->getWidth() : 0;}
+		float getHeight() const {return current ? current->getHeight() : 0;}
+
+		const ofPixels & getPixels() const {
+			static const ofPixels empty;
+			return current ? *current : empty;
+		}
+
+	protected:
+
+		/// stream frame format
+		enum Format {
+			RGB,
+			YUV420,
+			YUV444,
+			MONO
+		};
+
+		void threadedFunction() {
+			int width = rawSize.width, height = rawSize.height;
+			Format format = RGB;
+			bool fullRange = false;
+			if(!fill()) {return;}
+			if(std::string(buffer.data(), std::min<std::size_t>(bufferEnd, 9)) == "YUV4MPEG2") {
+				std::string header;
+				if(!readLine(header) || !parseHeader(header, width, height, format, fullRange)) {
+					ofLogError("PipeReader") << "unsupported y4m stream: " << header;
+					return;
+				}
+			}
+			else if(width <= 0 || height <= 0) {
+				ofLogError("PipeReader") << "raw rgb stream requires a size";
+				return;
+			}
+			ofLogVerbose("PipeReader") << "reading " << path << " " << width << "x" << height
+				<< (format == RGB ? " rgb" : " y4m");
+
+			std::size_t frameSize = getFrameSize(width, height, format);
+			std::vector<uint8_t> scratch(frameSize); // yuv frame or dropped frame
+			std::string line;
+			while(isThreadRunning()) {
+				if(format != RGB) {
+					if(!readLine(line)) {break;}
+					if(line.compare(0, 9, "YUV4MPEG2") == 0) { // writer restarted
+						if(!parseHeader(line, width, height, format, fullRange)) {
+							ofLogError("PipeReader") << "unsupported y4m stream: " << line;
+							break;
+						}
+						frameSize = getFrameSize(width, height, format);
+						scratch.resize(frameSize);
+						ofLogVerbose("PipeReader") << "restarted " << path << " "
+							<< width << "x" << height;
+						continue;
+					}
+					if(line.compare(0, 5, "FRAME") != 0) {break;}
+				}
+				ofPixels *pixels = nullptr;
+				free.pop(pixels);
+				if(pixels && ((int)pixels->getWidth() != width || (int)pixels->getHeight() != height)) {
+					pixels->allocate(width, height, OF_PIXELS_RGB);
+				}
+				uint8_t *dest = (pixels && format == RGB ? pixels->getData() : scratch.data());
+				if(!readExact(dest, frameSize)) {
+					break; // buffers are recycled on close
+				}
+				if(!pixels) {continue;} // all buffers in use, drop
+				const uint8_t *y = scratch.data(), *u = y + width * height;
+				switch(format) {
+					case YUV420:
+						Yuv::planarToRgb(y, u, u + ((width + 1) / 2) * ((height + 1) / 2),
+						                 width, height, 1, fullRange, pixels->getData());
+						break;
+					case YUV444:
+						Yuv::planarToRgb(y, u, u + width * height,
+						                 width, height, 0, fullRange, pixels->getData());
+						break;
+					case MONO: {
+						uint8_t *out = pixels->getData();
+						for(int i = 0; i < width * height; ++i, out += 3) {
+							Yuv::toRgb(y[i], 128, 128, fullRange, out);
+						}
+						break;
+					}
+					default: break;
+				}
+				frames.push(pixels); // never full, pool size
+			}
+			ofLogVerbose("PipeReader") << "stream ended " << path;
+		}
+
+		// returns stream frame size in bytes
+		static std::size_t getFrameSize(int width, int height, Format format) {
+			switch(format) {
+				case YUV420: return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+				case MONO: return width * height;
+				default: return width * height * 3; // RGB & YUV444
+			}
+		}
+
+		// parse y4m stream header, returns false if unsupported
+		static bool parseHeader(const std::string & header, int & width, int & height,
+		                        Format & format, bool & fullRange) {
+			format = YUV420; // default
+			for(auto & token : ofSplitString(header, " ", true, true)) {
+				switch(token[0]) {
+					case 'W': width = ofToInt(token.substr(1)); break;
+					case 'H': height = ofToInt(token.substr(1)); break;
+					case 'C':
+						if(token == "C420" || token == "C420jpeg" ||
+						   token == "C420mpeg2" || token == "C420paldv") {format = YUV420;}
+						else if(token == "C444") {format = YUV444;}
+						else if(token == "Cmono") {format = MONO;}
+						else {return false;} // ie. 4:2:2 or > 8 bit
+						break;
+					case 'X':
+						if(token == "XCOLORRANGE=FULL") {fullRange = true;}
+						break;
+					default: break;
+				}
+			}
+			return width > 0 && height > 0;
+		}
+
+		// read exactly size bytes, buffered bytes first, then straight into
+		// dest, returns false on end of stream or stop
+		bool readExact(uint8_t *dest, std::size_t size) {
+			std::size_t n = std::min(size, bufferEnd - bufferPos);
+			std::copy(buffer.data() + bufferPos, buffer.data() + bufferPos + n, dest);
+			bufferPos += n;
+			dest += n;
+			size -= n;
+			while(size > 0) {
+				long read = readSome(dest, size);
+				if(read <= 0) {return false;}
+				dest += read;
+				size -= read;
+			}
+			return true;
+		}
+
+		// read line without newline, returns false on end of stream or stop
+		bool readLine(std::string & line) {
+			line.clear();
+			while(line.size() < 1024) {
+				if(bufferPos == bufferEnd && !fill()) {return false;}
+				char c = buffer[bufferPos++];
+				if(c == '\n') {return true;}
+				line += c;
+			}
+			return false;
+		}
+
+		// refill read buffer, returns false on end of stream or stop
+		bool fill() {
+			bufferPos = bufferEnd = 0;
+			long read = readSome((uint8_t *)buffer.data(), buffer.size());
+			if(read <= 0) {return false;}
+			bufferEnd = read;
+			return true;
+		}
+
+		// read available bytes, waits for data, returns 0 on end of stream,
+		// < 0 on error or stop
+		//
+		// the fd stays blocking, polled first so a read never waits
+		long readSome(uint8_t *dest, std::size_t size) {
+		#ifndef TARGET_WIN32
+			while(isThreadRunning()) {
+				struct pollfd p = {fd, POLLIN, 0};
+				int ready = poll(&p, 1, 100); // time out to check for stop
+				if(ready == 0 || (ready < 0 && errno == EINTR)) {continue;}
+				ssize_t read = (ready > 0 ? ::read(fd, dest, size) : -1);
+				if(read >= 0) {return read;}
+				if(errno != EAGAIN && errno != EINTR) {
+					ofLogError("PipeReader") << "read error: " << strerror(errno);
+					return -1;
+				}
+			}
+		#endif
+			return -1;
+		}
+
+		// recycle all buffers, thread must be stopped
+		void reset() {
+			frames.reset();
+			free.reset();
+			for(auto & pixels : pool) {
+				free.push(&pixels);
+			}
+			current = nullptr;
+			newFrame = false;
+			bufferPos = bufferEnd = 0;
+		}
+
+		std::string path; ///< "-" for stdin or pipe path
+		int fd = -1; ///< stream file descriptor
+		struct {
+			int width = 0;
+			int height = 0;
+		} rawSize; ///< raw rgb frame size
+		std::array<char, BUFFER_SIZE> buffer; ///< header & line read buffer
+		std::size_t bufferPos = 0; ///< read position in buffer
+		std::size_t bufferEnd = 0; ///< end of valid bytes in buffer
+		std::array<ofPixels, POOL_SIZE> pool; ///< frame buffers
+		SpscQueue<ofPixels *, POOL_SIZE> free; ///< main -> reader, unused buffers
+		SpscQueue<ofPixels *, POOL_SIZE> frames; ///< reader -> main, read frames
+		ofPixels *current = nullptr; ///< current frame, held by main
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		bool textureDirty = false; ///< does the texture need an upload?
+		bool newFrame = false; ///< is the current frame new?
+		bool paused = false; ///< drop new frames?
+};
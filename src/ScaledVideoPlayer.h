@@ -0,0 +1,145 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofConstants.h"
+
+#ifdef TARGET_LINUX
+
+#include "ofGstVideoPlayer.h"
+#include <gst/video/video.h>
+
+// GStreamer video player which scales frames while decoding
+//
+// frames are scaled by videoscale on the decoded YUV planes before
+// videoconvert, so large videos are never converted to RGB at full size,
+// use with ofVideoPlayer::setPlayer() before loading
+//
+// loadAsync() returns without waiting for preroll, isLoaded() is true once
+// the pipeline is prerolled, ie. for preloading the next playlist video
+//
+// linux only, audio is not played & the volume is ignored
+class ScaledVideoPlayer : public ofBaseVideoPlayer {
+
+	public:
+
+		ScaledVideoPlayer(int width, int height) : width(width), height(height) {}
+		virtual ~ScaledVideoPlayer() {close();}
+
+		bool load(std::string name) {
+			return load(name, false);
+		}
+
+		void loadAsync(std::string name) {
+			load(name, true);
+		}
+
+		void close() {
+			videoUtils.close();
+			fps = 0;
+		}
+
+		void update() {
+			videoUtils.update();
+			if(fps == 0 && videoUtils.isLoaded()) {
+				fps = queryFps();
+			}
+		}
+
+		void play() {videoUtils.play();}
+		void stop() {videoUtils.stop();}
+		void setPaused(bool paused) {videoUtils.setPaused(paused);}
+
+		bool isFrameNew() const {return videoUtils.isFrameNew();}
+		ofPixels & getPixels() {return videoUtils.getPixels();}
+		const ofPixels & getPixels() const {return videoUtils.getPixels();}
+
+		bool setPixelFormat(ofPixelFormat pixelFormat) {
+			this->pixelFormat = pixelFormat;
+			return true;
+		}
+		ofPixelFormat getPixelFormat() const {return pixelFormat;}
+
+		float getWidth() const {return videoUtils.getWidth();}
+		float getHeight() const {return videoUtils.getHeight();}
+		bool isPaused() const {return videoUtils.isPaused();}
+		bool isLoaded() const {return videoUtils.isLoaded();}
+		bool isPlaying() const {return videoUtils.isPlaying();}
+		bool isInitialized() const {return isLoaded();}
+
+		float getPosition() const {return videoUtils.getPosition();}
+		float getSpeed() const {return videoUtils.getSpeed();}
+		float getDuration() const {return videoUtils.getDuration();}
+		bool getIsMovieDone() const {return videoUtils.getIsMovieDone();}
+		ofLoopType getLoopState() const {return videoUtils.getLoopState();}
+
+		void setPosition(float pct) {videoUtils.setPosition(pct);}
+		void setVolume(float volume) {} // no audio
+		void setLoopState(ofLoopType state) {videoUtils.setLoopState(state);}
+		void setSpeed(float speed) {videoUtils.setSpeed(speed);}
+
+		int getTotalNumFrames() const {return getDuration() * fps;}
+		int getCurrentFrame() const {return getPosition() * getTotalNumFrames();}
+
+		void setFrame(int frame) {
+			int total = getTotalNumFrames();
+			if(total > 0) {setPosition(ofClamp((float)frame / total, 0, 1));}
+		}
+		void firstFrame() {setPosition(0);}
+		void nextFrame() {setFrame(getCurrentFrame() + 1);}
+		void previousFrame() {setFrame(getCurrentFrame() - 1);}
+
+	protected:
+
+		// build & start pipeline, async does not wait for preroll
+		bool load(const std::string & name, bool async) {
+			close();
+			std::string path = ofToDataPath(name, true);
+			ofStringReplace(path, "\"", "\\\"");
+			std::string pipeline = "filesrc location=\"" + path + "\" ! decodebin ! "
+				"videoscale ! video/x-raw,width=" + ofToString(width) +
+				",height=" + ofToString(height) + " ! videoconvert";
+			// as a stream, the pipeline is loaded once prerolled
+			if(!videoUtils.setPipeline(pipeline, pixelFormat, async, width, height)) {
+				ofLogError("ScaledVideoPlayer") << "could not load " << name;
+				return false;
+			}
+			return videoUtils.startPipeline();
+		}
+
+		// frame rate from the negotiated sink caps, 0 if unknown
+		float queryFps() {
+			GstPad *pad = gst_element_get_static_pad(videoUtils.getSink(), "sink");
+			if(!pad) {return 0;}
+			float rate = 0;
+			GstCaps *caps = gst_pad_get_current_caps(pad);
+			if(caps) {
+				GstVideoInfo info;
+				if(gst_video_info_from_caps(&info, caps) && info.fps_d > 0) {
+					rate = (float)info.fps_n / info.fps_d;
+				}
+				gst_caps_unref(caps);
+			}
+			gst_object_unref(pad);
+			return rate;
+		}
+
+		ofGstVideoUtils videoUtils; ///< pipeline & appsink
+		ofPixelFormat pixelFormat = OF_PIXELS_RGB; ///< output pixel format
+		int width = 0; ///< decoded width
+		int height = 0; ///< decoded height
+		float fps = 0; ///< frame rate, 0 until known
+};
+
+#endif
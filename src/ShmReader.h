@@ -0,0 +1,211 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofTexture.h"
+#include "ofLog.h"
+
+#include <atomic>
+#include <cstring>
+#ifndef TARGET_WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// read frames from a POSIX shared memory ring buffer written by another
+// process, ie. tracking software which already holds camera frames
+//
+// layout, native endian:
+// * Header
+// * uint64 slot sequence * slot count
+// * frame slots, RGB width x height, slotSize bytes apart from dataOffset
+//
+// the producer publishes frame n into slot n % slot count:
+// 1. set slot sequence to 2n+1 (writing)
+// 2. write RGB frame into slot
+// 3. set slot sequence to 2n+2 (written), release
+// 4. set header sequence to n+1, release
+//
+// the reader polls the header sequence once per update without locks or
+// waiting & copies the newest slot, the slot sequence is checked before &
+// after the copy, so a frame overwritten while copying is dropped instead of
+// being used torn, the copy is owned & stays valid while the producer wraps
+//
+// the texture is only uploaded when the frame is drawn, not on windows
+class ShmReader {
+
+	public:
+
+		static const uint32_t VERSION = 1; ///< layout version
+
+		/// pixel formats
+		enum Format : uint32_t {
+			FORMAT_RGB = 0 ///< 8 bit RGB, 3 bytes per pixel
+		};
+
+		/// shared memory header, written once by the producer except sequence
+		struct Header {
+			char magic[8]; ///< "STYLSHM"
+			uint32_t version; ///< layout version
+			uint32_t width; ///< frame width
+			uint32_t height; ///< frame height
+			uint32_t format; ///< pixel format
+			uint32_t slotCount; ///< number of frame slots
+			uint32_t reserved;
+			uint64_t slotSize; ///< bytes per slot, min width * height * 3
+			uint64_t dataOffset; ///< slot 0 offset in bytes from start
+			std::atomic<uint64_t> sequence; ///< number of frames published
+		};
+
+		ShmReader() {}
+		ShmReader(const ShmReader &) = delete;
+		ShmReader & operator=(const ShmReader &) = delete;
+		virtual ~ShmReader() {close();}
+
+		/// attach to shared memory by name, ie. "/tracking", returns false if
+		/// missing or invalid
+		bool open(const std::string & name) {
+			close();
+		#ifdef TARGET_WIN32
+			ofLogError("ShmReader") << "shared memory input not supported on windows";
+			return false;
+		#else
+			int fd = shm_open(name.c_str(), O_RDONLY, 0);
+			if(fd < 0) {
+				ofLogError("ShmReader") << "could not open " << name;
+				return false;
+			}
+			struct stat st;
+			if(fstat(fd, &st) == 0 && st.st_size > 0) {
+				void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				if(mapped != MAP_FAILED) {
+					data = (uint8_t *)mapped;
+					length = st.st_size;
+				}
+			}
+			::close(fd);
+			if(!validate()) {
+				ofLogError("ShmReader") << "invalid shared memory frames " << name;
+				close();
+				return false;
+			}
+			return true;
+		#endif
+		}
+
+		/// detach, pixels must not be used after
+		void close() {
+		#ifndef TARGET_WIN32
+			if(data) {munmap(data, length);}
+		#endif
+			data = nullptr;
+			length = 0;
+			pixels.clear();
+			copy.clear();
+			texture.clear();
+			last = 0;
+			newFrame = false;
+		}
+
+		/// returns true if attached
+		bool isOpen() const {return data != nullptr;}
+
+		/// copy the newest published frame, if any
+		void update() {
+			newFrame = false;
+			if(!data || paused) {return;}
+			uint64_t published = header()->sequence.load(std::memory_order_acquire);
+			if(published == 0 || published == last) {return;}
+			uint64_t n = published - 1;
+			std::size_t slot = n % header()->slotCount;
+			const std::atomic<uint64_t> & sequence = slotSequence(slot);
+			if(sequence.load(std::memory_order_acquire) != 2 * n + 2) {
+				return; // already being overwritten, take the next
+			}
+			if(copy.getWidth() != header()->width || copy.getHeight() != header()->height) {
+				copy.allocate(header()->width, header()->height, OF_PIXELS_RGB);
+			}
+			std::memcpy(copy.getData(), data + header()->dataOffset + slot * header()->slotSize,
+			            copy.getTotalBytes());
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(sequence.load(std::memory_order_relaxed) != 2 * n + 2) {
+				return; // overwritten while copying, torn
+			}
+			std::swap(pixels, copy);
+			last = published;
+			textureDirty = true;
+			newFrame = true;
+		}
+
+		void draw(float x, float y) {
+			draw(x, y, getWidth(), getHeight());
+		}
+
+		void draw(float x, float y, float w, float h) {
+			if(!pixels.isAllocated()) {return;}
+			if(textureDirty) {
+				texture.loadData(pixels);
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		/// pause by ignoring new frames
+		void setPaused(bool paused) {this->paused = paused;}
+		bool isPaused() const {return paused;}
+
+		float getWidth() const {return data ? header()->width : 0;}
+		float getHeight() const {return data ? header()->height : 0;}
+
+		/// current frame, a validated copy of the shared slot
+		const ofPixels & getPixels() const {return pixels;}
+
+	protected:
+
+		static_assert(std::atomic<uint64_t>::is_always_lock_free,
+			"shared memory sequence must be lock free");
+
+		const Header * header() const {return (const Header *)data;}
+
+		const std::atomic<uint64_t> & slotSequence(std::size_t slot) const {
+			return ((const std::atomic<uint64_t> *)(data + sizeof(Header)))[slot];
+		}
+
+		// check header & bounds
+		bool validate() const {
+			if(!data || length < sizeof(Header)) {return false;}
+			const Header *h = header();
+			uint64_t frameSize = (uint64_t)h->width * h->height * 3;
+			return std::strncmp(h->magic, "STYLSHM", sizeof(h->magic)) == 0 &&
+			       h->version == VERSION && h->format == FORMAT_RGB &&
+			       h->width > 0 && h->height > 0 && h->slotCount > 0 &&
+			       h->slotSize >= frameSize &&
+			       h->dataOffset >= sizeof(Header) + h->slotCount * sizeof(uint64_t) &&
+			       h->dataOffset + (h->slotCount - 1) * h->slotSize + frameSize <= length;
+		}
+
+		uint8_t *data = nullptr; ///< mapped shared memory
+		std::size_t length = 0; ///< mapped length
+		ofPixels pixels; ///< current frame
+		ofPixels copy; ///< next frame, copied from a slot
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		uint64_t last = 0; ///< last taken header sequence
+		bool textureDirty = false; ///< does the texture need an upload?
+		bool newFrame = false; ///< is the current frame new?
+		bool paused = false; ///< ignore new frames?
+};
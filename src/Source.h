@@ -14,7 +14,13 @@
 #pragma once
 
 #include "ImagePlayer.h"
+#include "PackPlayer.h"
 #include "VideoPlayer.h"
+#include "VideoDecoder.h"
+#include "PipeReader.h"
+#include "ShmReader.h"
+#include "V4l2Capture.h"
+#include "HotFolder.h"
 
 /// base input frame source class
 class Source {
@@ -28,6 +34,9 @@ class Source {
 		}
 		virtual bool isFrameNew() = 0;
 		virtual const ofPixels & getPixels() = 0;
+		/// returns normalized 0-1 float RGB pixels if the source converts
+		/// directly to the model input format, otherwise nullptr
+		virtual const ofFloatPixels * getFloatPixels() {return nullptr;}
 		virtual int getWidth()  = 0;
 		virtual int getHeight() = 0;
 		virtual void setPaused(bool paused) {}
@@ -63,12 +72,12 @@ class ImageSource : public Source {
 		void stop() {player.stop();}
 };
 
-/// video player source
-class PlayerSource : public Source {
+/// pre-decoded frame pack source
+class PackSource : public Source {
 	public:
-		VideoPlayer player;
-		bool open(const std::vector<std::string> & paths) {
-			return player.load(paths);
+		PackPlayer player;
+		bool open(const std::string & path) {
+			return player.load(path);
 		}
 		void close() {player.close();}
 		void update() {player.update();}
@@ -85,7 +94,110 @@ class PlayerSource : public Source {
 		bool isLastFrame() {return player.isLastFrame();}
 		void play() {player.play();}
 		void stop() {player.stop();}
-		void setVolume(float v) {player.setVolume(v);}
+};
+
+/// video player source, optionally decoded on its own thread
+class PlayerSource : public Source {
+	public:
+		VideoPlayer player;
+		VideoDecoder decoder;
+		bool threaded = false; ///< use decoder thread? set before open()
+		bool open(const std::vector<std::string> & paths) {
+			return (threaded ? decoder.load(paths) : player.load(paths));
+		}
+		void close() {player.close(); decoder.close();}
+		void update() {threaded ? decoder.update() : player.update();}
+		void draw(float x, float y) {threaded ? decoder.draw(x, y) : player.draw(x, y);}
+		void draw(float x, float y, float w, float h) {
+			threaded ? decoder.draw(x, y, w, h) : player.draw(x, y, w, h);
+		}
+		bool isFrameNew() {return (threaded ? decoder.isFrameNew() : player.isFrameNew());}
+		const ofPixels & getPixels() {return (threaded ? decoder.getPixels() : player.getPixels());}
+		int getWidth() {return (threaded ? decoder.getWidth() : player.getWidth());}
+		int getHeight() {return (threaded ? decoder.getHeight() : player.getHeight());}
+		void setPaused(bool paused) {threaded ? decoder.setPaused(paused) : player.setPaused(paused);}
+		bool isPaused() {return (threaded ? decoder.isPaused() : player.isPaused());}
+		void nextFrame() {threaded ? decoder.nextFrame() : player.nextFrame();}
+		void previousFrame() {threaded ? decoder.previousFrame() : player.previousFrame();}
+		bool isLastFrame() {return (threaded ? decoder.isLastFrame() : player.isLastFrame());}
+		void play() {threaded ? decoder.play() : player.play();}
+		void stop() {threaded ? decoder.stop() : player.stop();}
+		void setVolume(float v) {threaded ? decoder.setVolume(v) : player.setVolume(v);}
+		void nextVideo() {threaded ? decoder.nextVideo() : player.nextVideo();}
+		void previousVideo() {threaded ? decoder.previousVideo() : player.previousVideo();}
+		void setLockstep(bool l) {threaded ? decoder.setLockstep(l) : player.setLockstep(l);}
+		void step() {threaded ? decoder.step() : player.step();}
+		void setDecodeSize(int w, int h) {
+			player.setDecodeSize(w, h);
+			decoder.setDecodeSize(w, h);
+		}
+};
+
+/// stdin or named pipe stream source
+class PipeSource : public Source {
+	public:
+		PipeReader reader;
+		bool open(const std::string & path, int width, int height) {
+			return reader.open(path, width, height);
+		}
+		void close() {reader.close();}
+		void update() {reader.update();}
+		void draw(float x, float y) {reader.draw(x, y);}
+		void draw(float x, float y, float w, float h) {reader.draw(x, y, w, h);}
+		bool isFrameNew() {return reader.isFrameNew();}
+		const ofPixels & getPixels() {return reader.getPixels();}
+		int getWidth() {return reader.getWidth();}
+		int getHeight() {return reader.getHeight();}
+		void setPaused(bool paused) {reader.setPaused(paused);}
+		bool isPaused() {return reader.isPaused();}
+};
+
+/// shared memory ring buffer source
+class ShmSource : public Source {
+	public:
+		ShmReader reader;
+		bool open(const std::string & name) {
+			return reader.open(name);
+		}
+		void close() {reader.close();}
+		void update() {reader.update();}
+		void draw(float x, float y) {reader.draw(x, y);}
+		void draw(float x, float y, float w, float h) {reader.draw(x, y, w, h);}
+		bool isFrameNew() {return reader.isFrameNew();}
+		const ofPixels & getPixels() {return reader.getPixels();}
+		int getWidth() {return reader.getWidth();}
+		int getHeight() {return reader.getHeight();}
+		void setPaused(bool paused) {reader.setPaused(paused);}
+		bool isPaused() {return reader.isPaused();}
+};
+
+/// watched hot folder source, results are written per image
+class WatchSource : public Source {
+	public:
+		HotFolder folder;
+		unsigned long inputId = 0; ///< model input id of the current image
+		bool open(const std::string & inputDir, const std::string & outputDir,
+		          std::size_t threads) {
+			return folder.open(inputDir, outputDir, threads);
+		}
+		void close() {
+			folder.close();
+			inputId = 0;
+		}
+		void update() {folder.update();}
+		void draw(float x, float y) {draw(x, y, getWidth(), getHeight());}
+		void draw(float x, float y, float w, float h) {folder.draw(x, y, w, h);}
+		bool isFrameNew() {return folder.isFrameNew();}
+		const ofPixels & getPixels() {return folder.getPixels();}
+		int getWidth() {return folder.getWidth();}
+		int getHeight() {return folder.getHeight();}
+		/// write model output if it is the result for the current image
+		void output(unsigned long outputId, const ofPixels & pixels) {
+			if(inputId > 0 && outputId == inputId) {
+				folder.write(pixels);
+				inputId = 0;
+			}
+		}
 };
 
 /// camera input source settings
@@ -103,6 +215,9 @@ struct CameraSourceSettings {
 };
 
 /// camera input source
+///
+/// frames are only mirrored when their pixels are requested & only uploaded
+/// when drawn, so an undrawn camera does no texture work
 class CameraSource : public Source {
 	public:
 		// ofVideograbber doesn't seem to like setup()/close() cycles,
@@ -112,7 +227,6 @@ class CameraSource : public Source {
 			bool vert = false; ///< flip
 			bool horz = false; ///< mirror
 		} mirror;
-		ofImage image; ///< mirrored pixels buffer
 		bool setup(const CameraSourceSettings & settings) {
 			mirror.vert = settings.mirror.vert;
 			mirror.horz = settings.mirror.horz;
@@ -124,40 +238,170 @@ class CameraSource : public Source {
 			grabber = new ofVideoGrabber();
 			grabber->setDesiredFrameRate(fps);
 			grabber->setDeviceID(deviceID);
+			grabber->setUseTexture(false); // uploaded in draw() instead
+			settings.size.width = size.width = w;
+			settings.size.height = size.height = h;
+			settings.rate = fps;
+			settings.device = deviceID;
 			return grabber->setup(w, h);
 		}
+		/// stop capturing while unused, closes the device & its capture
+		/// thread, the settings & frame size are kept, see resume()
+		void suspend() {
+			if(!grabber) {return;}
+			if(grabber->isInitialized()) {
+				size.width = grabber->getWidth();
+				size.height = grabber->getHeight();
+			}
+			close();
+			suspended = true;
+		}
+		/// reopen device after suspend() with a new grabber, blocks until the
+		/// device is open, returns false on error & stays suspended
+		bool resume() {
+			if(!suspended) {return grabber != nullptr;}
+			int w = size.width, h = size.height;
+			if(!setup(settings.size.width, settings.size.height, settings.rate, settings.device)) {
+				close();
+				size.width = w;
+				size.height = h;
+				return false;
+			}
+			suspended = false;
+			return true;
+		}
+		/// returns true if suspended
+		bool isSuspended() const {return suspended;}
 		void close() {
 			if(grabber) {
 				grabber->close();
 				delete grabber;
 				grabber = nullptr;
 			}
+			pixels.clear();
+			texture.clear();
+			pixelsDirty = textureDirty = false;
 		}
 		void update() {
+			if(!grabber) {return;}
 			grabber->update();
 			if(grabber->isFrameNew()) {
-				if(mirror.vert || mirror.horz) {
-					image.setFromPixels(grabber->getPixels());
-					image.mirror(mirror.vert, mirror.horz);
-				}
-				else if(image.isAllocated()) {
-					image.clear();
-				}
+				pixelsDirty = textureDirty = true;
 			}
 		}
-		void draw(float x, float y) {
-			if(image.isAllocated()) {image.draw(x, y);}
-			else {grabber->draw(x, y);}
-		}
+		void draw(float x, float y) {draw(x, y, getWidth(), getHeight());}
 		void draw(float x, float y, float w, float h) {
-			if(image.isAllocated()) {image.draw(x, y, w, h);}
-			else {grabber->draw(x, y, w, h);}
+			const ofPixels & current = getPixels();
+			if(textureDirty && current.isAllocated()) {
+				texture.loadData(current);
+				textureDirty = false;
+			}
+			if(texture.isAllocated()) {texture.draw(x, y, w, h);}
 		}
-		bool isFrameNew() {return grabber->isFrameNew();}
+		bool isFrameNew() {return grabber && grabber->isFrameNew();}
+		/// current frame, mirrored on first request
 		const ofPixels & getPixels() {
-			if(image.isAllocated()) {return image.getPixels();}
-			return grabber->getPixels();
+			if(mirror.vert != mirrored.vert || mirror.horz != mirrored.horz) {
+				mirrored.vert = mirror.vert;
+				mirrored.horz = mirror.horz;
+				pixelsDirty = textureDirty = true;
+			}
+			if(!grabber) {return pixels;} // cleared
+			const ofPixels & frame = grabber->getPixels();
+			if(!mirror.vert && !mirror.horz) {return frame;}
+			if(pixelsDirty && frame.isAllocated()) {
+				pixels.allocate(frame.getWidth(), frame.getHeight(), frame.getPixelFormat());
+				frame.mirrorTo(pixels, mirror.vert, mirror.horz);
+				pixelsDirty = false;
+			}
+			return pixels;
+		}
+		int getWidth() {return grabber ? grabber->getWidth() : size.width;}
+		int getHeight() {return grabber ? grabber->getHeight() : size.height;}
+	protected:
+		CameraSourceSettings settings; ///< device, rate, & size for resume()
+		struct {
+			int width = 0;
+			int height = 0;
+		} size; ///< requested or, once suspended, last frame size
+		bool suspended = false; ///< closed by suspend()?
+		ofPixels pixels; ///< mirrored frame, on request
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		struct {
+			bool vert = false;
+			bool horz = false;
+		} mirrored; ///< mirror applied to pixels
+		bool pixelsDirty = false; ///< do the pixels need mirroring?
+		bool textureDirty = false; ///< does the texture need an upload?
+};
+
+/// additional cameras processed as one batch with the camera source, camera
+/// i is model input stream i + 1, see ofxStyleTransfer::setStreams()
+class CameraStreams {
+	public:
+		std::vector<std::unique_ptr<CameraSource>> cameras;
+		/// open a camera for each device with the same settings
+		bool setup(const std::vector<int> & devices, CameraSourceSettings settings) {
+			close();
+			bool opened = true;
+			for(int device : devices) {
+				settings.device = device;
+				cameras.emplace_back(new CameraSource);
+				if(!cameras.back()->setup(settings)) {
+					ofLogWarning("CameraStreams") << "could not open camera " << device;
+					opened = false;
+				}
+			}
+			return opened;
+		}
+		void close() {
+			for(auto & camera : cameras) {camera->close();}
+			cameras.clear();
+		}
+		void update() {
+			for(auto & camera : cameras) {camera->update();}
+		}
+		void setMirror(bool horz, bool vert) {
+			for(auto & camera : cameras) {
+				camera->mirror.horz = horz;
+				camera->mirror.vert = vert;
+			}
+		}
+		bool empty() const {return cameras.empty();}
+		std::size_t size() const {return cameras.size();}
+		CameraSource & operator[](std::size_t index) {return *cameras[index];}
+};
+
+/// Video4Linux2 camera source, linux only
+class V4l2Source : public Source {
+	public:
+		V4l2Capture capture;
+		struct {
+			bool vert = false; ///< flip
+			bool horz = false; ///< mirror
+		} mirror;
+		/// open device, captures MJPEG decoded on threads if mjpeg is true
+		bool open(const std::string & device, const CameraSourceSettings & settings,
+		          bool mjpeg=false) {
+			mirror.vert = settings.mirror.vert;
+			mirror.horz = settings.mirror.horz;
+			return capture.open(device, settings.size.width, settings.size.height,
+			                    settings.rate, mjpeg);
+		}
+		/// min MJPEG decode size, set before open()
+		void setDecodeSize(int width, int height) {capture.setDecodeSize(width, height);}
+		void close() {capture.close();}
+		void update() {
+			capture.setMirror(mirror.horz, mirror.vert);
+			capture.update();
+		}
+		void draw(float x, float y) {draw(x, y, getWidth(), getHeight());}
+		void draw(float x, float y, float w, float h) {capture.draw(x, y, w, h);}
+		bool isFrameNew() {return capture.isFrameNew();}
+		const ofPixels & getPixels() {return capture.getPixels();}
+		const ofFloatPixels * getFloatPixels() {
+			return capture.isCompressed() ? nullptr : &capture.getFloatPixels();
 		}
-		int getWidth() {return grabber->getWidth();}
-		int getHeight() {return grabber->getHeight();}
+		int getWidth() {return capture.getWidth();}
+		int getHeight() {return capture.getHeight();}
 };
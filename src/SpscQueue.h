@@ -0,0 +1,68 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/// bounded lock-free single producer, single consumer queue
+///
+/// push() must only be called from one thread & pop() from one other thread,
+/// neither blocks nor allocates
+template<typename T, std::size_t N>
+class SpscQueue {
+
+	public:
+
+		/// push value, returns false if full, producer thread only
+		bool push(const T & value) {
+			std::size_t t = tail.load(std::memory_order_relaxed);
+			std::size_t next = (t + 1) % SLOTS;
+			if(next == head.load(std::memory_order_acquire)) {return false;}
+			slots[t] = value;
+			tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/// pop oldest value, returns false if empty, consumer thread only
+		bool pop(T & value) {
+			std::size_t h = head.load(std::memory_order_relaxed);
+			if(h == tail.load(std::memory_order_acquire)) {return false;}
+			value = slots[h];
+			head.store((h + 1) % SLOTS, std::memory_order_release);
+			return true;
+		}
+
+		/// returns true if empty, exact on the consumer thread
+		bool empty() const {
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+		/// returns max number of values
+		static constexpr std::size_t capacity() {return N;}
+
+		/// remove all values, not thread safe: only while neither side is used
+		void reset() {
+			head.store(0);
+			tail.store(0);
+		}
+
+	protected:
+
+		static const std::size_t SLOTS = N + 1; ///< one slot is always empty
+
+		std::array<T, SLOTS> slots; ///< ring buffer
+		alignas(64) std::atomic<std::size_t> head{0}; ///< next pop, consumer
+		alignas(64) std::atomic<std::size_t> tail{0}; ///< next push, producer
+};
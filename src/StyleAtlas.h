@@ -0,0 +1,196 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofTexture.h"
+#include "StyleCache.h"
+
+#include <condition_variable>
+
+/// packed thumbnail texture for a style library
+///
+/// thumbnails are fit into square cells of a single texture which is built
+/// on a background thread & uploaded on the main thread, so drawing a
+/// library style does not require a texture upload per style change
+///
+/// styles are not decoded by the atlas: thumbnails are taken from the cache
+/// as its background pass decodes them & the texture is uploaded again at
+/// most once per UPDATE_INTERVAL while the pass adds thumbnails
+class StyleAtlas : public ofThread {
+
+	public:
+
+		static const int CELL_SIZE = 128; ///< max cell size in pixels
+		static const int MIN_CELL_SIZE = 32; ///< min cell size in pixels
+		static const int MAX_SIZE = 4096; ///< max texture width or height
+		static const int UPDATE_INTERVAL = 1000; ///< min ms between uploads while decoding
+
+		virtual ~StyleAtlas() {
+			stop();
+		}
+
+		/// start building atlas from the first count styles in cache, cells
+		/// from a previous build are cleared as style indices may have changed
+		void setup(StyleCache & cache, std::size_t count) {
+			stop();
+			texture.clear();
+			cells.clear();
+			std::lock_guard<std::mutex> lock(mutex);
+			this->cache = &cache;
+			this->count = count;
+			ready = false;
+			startThread();
+		}
+
+		/// stop building
+		void clear() {
+			stop();
+			texture.clear();
+			cells.clear();
+		}
+
+		/// upload atlas when built, call on the main thread
+		/// returns true if the texture was updated
+		bool update() {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(!ready) {return false;}
+			if(texture.getWidth() != built.pixels.getWidth() ||
+			   texture.getHeight() != built.pixels.getHeight()) {
+				texture.allocate(built.pixels);
+			}
+			texture.loadData(built.pixels);
+			cells = std::move(built.cells);
+			built.pixels.clear();
+			ready = false;
+			return true;
+		}
+
+		/// returns true if the atlas texture is uploaded
+		bool isAllocated() const {return texture.isAllocated();}
+
+		/// returns the number of cells
+		std::size_t size() const {return cells.size();}
+
+		/// returns true if a style index has a thumbnail in the atlas
+		bool hasCell(int index) const {
+			return index >= 0 && (std::size_t)index < cells.size() && cells[index].width > 0;
+		}
+
+		/// returns thumbnail rect within the atlas texture in pixels
+		const ofRectangle & getCell(std::size_t index) const {return cells[index];}
+
+		/// draw thumbnail for a style index
+		void drawCell(std::size_t index, float x, float y, float w, float h) const {
+			const ofRectangle & r = cells[index];
+			texture.drawSubsection(x, y, w, h, r.x, r.y, r.width, r.height);
+		}
+
+		/// returns atlas texture
+		const ofTexture & getTexture() const {return texture;}
+
+	protected:
+
+		void threadedFunction() {
+
+			// layout: square grid of cells, smaller cells for large libraries
+			int columns = std::max((int)ceil(sqrt((double)count)), 1);
+			int cell = ofClamp(MAX_SIZE / columns, MIN_CELL_SIZE, CELL_SIZE);
+			columns = std::min(columns, MAX_SIZE / cell);
+			std::size_t capacity = columns * (MAX_SIZE / cell);
+			if(count > capacity) {
+				ofLogWarning("StyleAtlas") << "only first " << capacity
+					<< " of " << count << " styles fit into atlas";
+			}
+			std::size_t cellCount = std::min(count, capacity);
+			int rows = std::max((int)ceil((double)cellCount / columns), 1);
+
+			ofPixels pixels;
+			pixels.allocate(columns * cell, rows * cell, OF_PIXELS_RGB);
+			pixels.set(0);
+			std::vector<ofRectangle> rects(cellCount, ofRectangle(0, 0, 0, 0));
+			std::vector<bool> done(cellCount, false);
+			std::size_t remaining = cellCount;
+			ofPixels thumbnail;
+			bool first = true;
+			while(isThreadRunning()) {
+
+				// add thumbnails decoded by the cache since the last pass,
+				// checked before so styles decoded during the pass are added
+				bool decoding = cache->isDecoding();
+				bool added = false;
+				for(std::size_t i = 0; i < cellCount && remaining > 0; ++i) {
+					if(!isThreadRunning()) {return;}
+					if(done[i]) {continue;}
+					auto style = cache->get(i);
+					if(!style) {continue;}
+					done[i] = true;
+					remaining--;
+					if(!style->thumbnail.isAllocated()) {continue;}
+
+					// fit & center in cell
+					const ofPixels & src = style->thumbnail;
+					float scale = std::min((float)cell / src.getWidth(), (float)cell / src.getHeight());
+					int w = std::max((int)(src.getWidth() * scale), 1);
+					int h = std::max((int)(src.getHeight() * scale), 1);
+					int x = (i % columns) * cell + (cell - w) / 2;
+					int y = (i / columns) * cell + (cell - h) / 2;
+					thumbnail.allocate(w, h, OF_PIXELS_RGB);
+					src.resizeTo(thumbnail, OF_INTERPOLATE_BILINEAR);
+					thumbnail.pasteInto(pixels, x, y);
+					rects[i].set(x, y, w, h);
+					added = true;
+				}
+
+				// publish, moved if final
+				bool final = (remaining == 0 || !decoding);
+				if(added || first) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if(final) {built.pixels = std::move(pixels);}
+					else {built.pixels = pixels;}
+					built.cells = rects;
+					ready = true;
+				}
+				if(final) {return;}
+				first = false;
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait_for(lock, std::chrono::milliseconds(UPDATE_INTERVAL),
+					[this] {return !isThreadRunning();});
+			}
+		}
+
+		// stop thread & wake it if waiting for the cache
+		void stop() {
+			stopThread();
+			{
+				std::lock_guard<std::mutex> lock(mutex); // don't miss the wake up
+				condition.notify_all();
+			}
+			waitForThread(false);
+		}
+
+		StyleCache *cache = nullptr; ///< style source
+		std::size_t count = 0; ///< number of styles
+
+		/// atlas built in the background, uploaded in update()
+		struct {
+			ofPixels pixels;
+			std::vector<ofRectangle> cells;
+		} built;
+		bool ready = false; ///< built atlas ready for upload?
+
+		ofTexture texture; ///< uploaded atlas
+		std::vector<ofRectangle> cells; ///< uploaded thumbnail rects by style index
+		std::condition_variable condition; ///< wakes the thread to stop
+};
@@ -0,0 +1,368 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofImage.h"
+#include "ofxStyleTransfer.h"
+#include "StyleManifest.h"
+#include "ImageDecoder.h"
+
+#include <condition_variable>
+
+/// style image cache which decodes a library of style image paths on a
+/// background thread
+///
+/// only the small model-ready pixels & a thumbnail are kept per style, not
+/// the full resolution source image, so memory use is bounded per style
+///
+/// with a manifest, styles decoded in a previous run are used directly from
+/// the mapped manifest file & only new or changed images are decoded, the
+/// manifest is rewritten in the background when the library has changed,
+/// including styles decoded on demand by load() after the background pass
+class StyleCache : public ofThread {
+
+	public:
+
+		static const int THUMB_SIZE = 240; ///< max thumbnail width or height
+
+		virtual ~StyleCache() {
+			stop();
+		}
+
+		/// open style manifest file, creates it on the next setup if missing,
+		/// call once before setup() as cached styles reference the manifest
+		/// returns true if an existing valid manifest was opened
+		bool openManifest(const std::string & path) {
+			stop();
+			manifestPath = path;
+			return manifest.open(path, ofxStyleTransfer::STYLE_W, ofxStyleTransfer::STYLE_H) &&
+			       manifest.size() > 0;
+		}
+
+		/// returns style image paths from the open manifest, if any
+		std::vector<std::string> getManifestPaths() const {
+			return manifest.getPaths();
+		}
+
+		/// set style image paths & start decoding in the background,
+		/// optional scan function lists the current library paths which are
+		/// checked for added & removed images after decoding
+		void setup(const std::vector<std::string> & paths,
+		           std::function<std::vector<std::string>()> scan=nullptr) {
+			stop();
+			std::lock_guard<std::mutex> lock(mutex);
+			this->paths = paths;
+			this->scan = scan;
+			styles.assign(paths.size(), nullptr);
+			queue.clear();
+			for(std::size_t i = 0; i < paths.size(); ++i) {
+				int entry = manifest.find(paths[i]);
+				if(entry >= 0) {
+					// use now, verified against the file in the background
+					styles[i] = manifest.getStyle(entry);
+				}
+				queue.push_back(i);
+			}
+			rescanned.clear();
+			changed = false;
+			dirty = (!manifestPath.empty() && !manifest.isOpen());
+			decoding = true;
+			startThread();
+		}
+
+		/// stop decoding & clear cache
+		void clear() {
+			stop();
+			std::lock_guard<std::mutex> lock(mutex);
+			paths.clear();
+			styles.clear();
+			queue.clear();
+			rescanned.clear();
+			changed = false;
+			decoding = false;
+		}
+
+		/// apply library changes found in the background, call on the main
+		/// thread, returns true if the paths have changed, see getPaths()
+		bool update() {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(!changed) {return false;}
+			paths = std::move(rescanned.paths);
+			styles = std::move(rescanned.styles);
+			rescanned.clear();
+			changed = false;
+			return true;
+		}
+
+		/// returns the current style image paths
+		std::vector<std::string> getPaths() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return paths;
+		}
+
+		/// returns cached style by index or nullptr if not decoded yet
+		std::shared_ptr<const Style> get(std::size_t index) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(index >= styles.size()) {return nullptr;}
+			return styles[index];
+		}
+
+		/// returns cached style by index, decodes now if not decoded yet
+		/// returns nullptr if the image could not be loaded
+		std::shared_ptr<const Style> load(std::size_t index) {
+			std::string path;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if(index >= styles.size()) {return nullptr;}
+				if(styles[index]) {return styles[index];}
+				path = paths[index];
+			}
+			auto style = decode(path);
+			if(style) {
+				std::lock_guard<std::mutex> lock(mutex);
+				styles[index] = style;
+				dirty = true;
+				condition.notify_all(); // save, background pass may be done
+			}
+			return style;
+		}
+
+		/// move an index to the front of the background decode queue
+		void prioritize(std::size_t index) {
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = std::find(queue.begin(), queue.end(), index);
+			if(found != queue.end()) {
+				queue.erase(found);
+				queue.push_front(index);
+			}
+		}
+
+		/// returns the number of decoded styles
+		std::size_t getNumLoaded() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return styles.size() - std::count(styles.begin(), styles.end(), nullptr);
+		}
+
+		/// returns true while the background pass is decoding styles, styles
+		/// which are not decoded afterwards could not be loaded
+		bool isDecoding() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return decoding;
+		}
+
+		/// decode style image at path into model-ready pixels & thumbnail with
+		/// file info & content hash, safe to call from any thread, returns
+		/// nullptr on error
+		static std::shared_ptr<Style> decode(const std::string & path) {
+			int64_t mtime;
+			uint64_t size;
+			std::shared_ptr<Style> style;
+			if(StyleManifest::stat(path, mtime, size)) {
+				ofBuffer buffer = ofBufferFromFile(path, true);
+				style = decode(path, buffer, mtime, size,
+				               StyleManifest::hash(buffer.getData(), buffer.size()));
+			}
+			if(!style) {
+				ofLogWarning("StyleCache") << "could not load " << path;
+			}
+			return style;
+		}
+
+		/// create style from image pixels, safe to call from any thread
+		static std::shared_ptr<Style> fromPixels(ofPixels & pixels, const std::string & path="") {
+			if(pixels.getImageType() != OF_IMAGE_COLOR) {
+				// model requires RGB without alpha
+				pixels.setImageType(OF_IMAGE_COLOR);
+			}
+			auto style = std::make_shared<Style>();
+			style->path = path;
+			style->width = pixels.getWidth();
+			style->height = pixels.getHeight();
+			style->pixels.allocate(ofxStyleTransfer::STYLE_W, ofxStyleTransfer::STYLE_H, OF_PIXELS_RGB);
+			pixels.resizeTo(style->pixels, OF_INTERPOLATE_BICUBIC);
+			float scale = (float)THUMB_SIZE / std::max(pixels.getWidth(), pixels.getHeight());
+			if(scale < 1) {
+				style->thumbnail.allocate(std::max((int)(pixels.getWidth() * scale), 1),
+				                          std::max((int)(pixels.getHeight() * scale), 1),
+				                          OF_PIXELS_RGB);
+				pixels.resizeTo(style->thumbnail, OF_INTERPOLATE_BICUBIC);
+			}
+			else {
+				style->thumbnail = pixels;
+			}
+			return style;
+		}
+
+	protected:
+
+		// stop thread & wake it if waiting to save
+		void stop() {
+			stopThread();
+			{
+				std::lock_guard<std::mutex> lock(mutex); // don't miss the wake up
+				condition.notify_all();
+			}
+			waitForThread(false);
+		}
+
+		void threadedFunction() {
+
+			// decode new & verify styles from the manifest
+			while(isThreadRunning()) {
+				std::size_t index;
+				std::string path;
+				std::shared_ptr<const Style> current;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if(queue.empty()) { // done
+						decoding = false;
+						break;
+					}
+					index = queue.front();
+					queue.pop_front();
+					path = paths[index];
+					current = styles[index];
+				}
+				if(isCurrent(current)) {continue;}
+				auto style = decodeFile(path);
+				std::lock_guard<std::mutex> lock(mutex);
+				if(index < styles.size() && styles[index] == current) {
+					styles[index] = style;
+					dirty = true;
+				}
+			}
+
+			// check library for added & removed images
+			if(scan && isThreadRunning()) {
+				std::vector<std::string> found = scan();
+				std::vector<std::string> previous;
+				std::vector<std::shared_ptr<const Style>> cached;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					previous = paths;
+					cached = styles;
+				}
+				if(!found.empty() && found != previous) {
+					std::map<std::string, std::shared_ptr<const Style>> byPath;
+					for(std::size_t i = 0; i < previous.size(); ++i) {
+						byPath[previous[i]] = cached[i];
+					}
+					std::vector<std::shared_ptr<const Style>> rescannedStyles;
+					for(auto & path : found) {
+						if(!isThreadRunning()) {return;}
+						auto style = byPath[path];
+						if(!style) {style = decodeFile(path);}
+						rescannedStyles.push_back(style);
+					}
+					ofLogVerbose("StyleCache") << "library changed: "
+						<< previous.size() << " -> " << found.size() << " styles";
+					std::lock_guard<std::mutex> lock(mutex);
+					rescanned.paths = std::move(found);
+					rescanned.styles = std::move(rescannedStyles);
+					changed = true;
+					dirty = true;
+				}
+			}
+
+			// save manifest, again whenever load() decodes a style later
+			while(isThreadRunning()) {
+				std::vector<std::shared_ptr<const Style>> save;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [this] {
+						return !isThreadRunning() || (dirty && !manifestPath.empty());
+					});
+					if(!isThreadRunning()) {break;}
+					save = (changed ? rescanned.styles : styles);
+					dirty = false;
+				}
+				if(StyleManifest::write(manifestPath, ofxStyleTransfer::STYLE_W,
+				                        ofxStyleTransfer::STYLE_H, save)) {
+					ofLogVerbose("StyleCache") << "wrote manifest " << manifestPath;
+				}
+			}
+		}
+
+		// returns true if a style is unchanged on disk, requires file info &
+		// hash, ie. entries saved without a hash are decoded again once
+		bool isCurrent(const std::shared_ptr<const Style> & style) {
+			if(!style || style->size == 0 || style->hash == 0) {return false;}
+			int64_t mtime;
+			uint64_t size;
+			return StyleManifest::stat(style->path, mtime, size) &&
+			       mtime == style->mtime && size == style->size;
+		}
+
+		// read & decode style image with file info & content hash,
+		// reuses manifest data if the content is known, ie. renamed files
+		std::shared_ptr<const Style> decodeFile(const std::string & path) {
+			auto style = std::make_shared<Style>();
+			if(!StyleManifest::stat(path, style->mtime, style->size)) {
+				ofLogWarning("StyleCache") << "could not load " << path;
+				return nullptr;
+			}
+			ofBuffer buffer = ofBufferFromFile(path, true);
+			uint64_t hash = StyleManifest::hash(buffer.getData(), buffer.size());
+			int entry = manifest.findHash(hash, buffer.size());
+			if(entry >= 0) {
+				auto known = manifest.getStyle(entry);
+				known->path = path;
+				known->mtime = style->mtime;
+				return known;
+			}
+			auto decoded = decode(path, buffer, style->mtime, style->size, hash);
+			if(!decoded) {
+				ofLogWarning("StyleCache") << "could not load " << path;
+			}
+			return decoded;
+		}
+
+		// decode read style image with file info & content hash
+		static std::shared_ptr<Style> decode(const std::string & path, const ofBuffer & buffer,
+		                                     int64_t mtime, uint64_t size, uint64_t hash) {
+			ofPixels pixels;
+			if(!ImageDecoder::load(pixels, buffer, ofxStyleTransfer::STYLE_W, ofxStyleTransfer::STYLE_H)) {
+				return nullptr;
+			}
+			auto style = fromPixels(pixels, path);
+			style->mtime = mtime;
+			style->size = size;
+			style->hash = hash;
+			return style;
+		}
+
+		// declared first as manifest styles reference its mapped data
+		StyleManifest manifest; ///< mapped manifest, if any
+		std::string manifestPath = ""; ///< manifest path, written if dirty
+		bool dirty = false; ///< styles differ from manifest?
+
+		std::vector<std::string> paths; ///< style image paths
+		std::vector<std::shared_ptr<const Style>> styles; ///< decoded styles by path index
+		std::deque<std::size_t> queue; ///< path indices to decode
+		std::function<std::vector<std::string>()> scan = nullptr; ///< library scan function
+
+		/// library changes from background scan, applied in update()
+		struct {
+			std::vector<std::string> paths;
+			std::vector<std::shared_ptr<const Style>> styles;
+			void clear() {
+				paths.clear();
+				styles.clear();
+			}
+		} rescanned;
+		bool changed = false; ///< rescanned library is ready?
+		bool decoding = false; ///< is the background pass decoding?
+		std::condition_variable condition; ///< wakes the thread to save
+};
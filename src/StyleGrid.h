@@ -0,0 +1,137 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofVboMesh.h"
+#include "StyleAtlas.h"
+
+/// scrollable grid view of a style atlas
+///
+/// visible cells are drawn as a single mesh with the atlas texture bound,
+/// the mesh is only rebuilt when scrolled, resized, or the atlas changes
+class StyleGrid {
+
+	public:
+
+		/// set atlas to draw, must outlive the grid
+		void setup(const StyleAtlas & atlas) {
+			this->atlas = &atlas;
+			dirty = true;
+		}
+
+		/// set draw size & preferred cell size
+		void setSize(float width, float height, float cellSize=128) {
+			this->width = width;
+			this->height = height;
+			columns = std::max((int)(width / cellSize), 1);
+			cell = width / columns;
+			scroll(0);
+			dirty = true;
+		}
+
+		/// mark mesh for rebuild, ie. atlas updated
+		void setDirty() {dirty = true;}
+
+		/// scroll by amount in pixels, positive scrolls down
+		void scroll(float amount) {
+			float rows = atlas ? ceil((float)atlas->size() / columns) : 0;
+			float max = std::max(rows * cell - height, 0.f);
+			offset = ofClamp(offset + amount, 0, max);
+			dirty = true;
+		}
+
+		/// scroll so index is visible
+		void scrollTo(int index) {
+			if(index < 0) {return;}
+			float y = (index / columns) * cell - offset;
+			if(y < 0) {scroll(y);}
+			else if(y + cell > height) {scroll(y + cell - height);}
+		}
+
+		/// returns style index at draw position or -1 if none
+		int getIndex(float x, float y) const {
+			if(!atlas || x < 0 || x >= width || y < 0 || y >= height) {return -1;}
+			int index = (int)((y + offset) / cell) * columns + (int)(x / cell);
+			return (atlas->hasCell(index) ? index : -1);
+		}
+
+		/// draw visible cells & highlight selected index
+		void draw(int selected=-1) {
+			if(!atlas || !atlas->isAllocated()) {return;}
+			if(dirty) {
+				rebuild();
+			}
+			ofPushStyle();
+			ofSetColor(0, 0, 0, 200);
+			ofDrawRectangle(0, 0, width, height);
+			ofSetColor(255);
+			atlas->getTexture().bind();
+			mesh.draw();
+			atlas->getTexture().unbind();
+			if(selected >= 0 && (std::size_t)selected < atlas->size()) {
+				float y = (selected / columns) * cell - offset;
+				if(y > -cell && y < height) {
+					ofNoFill();
+					ofSetLineWidth(2);
+					ofDrawRectangle((selected % columns) * cell + 1, y + 1, cell - 2, cell - 2);
+				}
+			}
+			ofPopStyle();
+		}
+
+	protected:
+
+		// add quads for visible cells, fit into cells like the atlas
+		void rebuild() {
+			mesh.clear();
+			mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+			const ofTexture & texture = atlas->getTexture();
+			std::size_t first = (std::size_t)(offset / cell) * columns;
+			std::size_t last = std::min((std::size_t)ceil((offset + height) / cell) * columns,
+			                            atlas->size());
+			for(std::size_t i = first; i < last; ++i) {
+				if(!atlas->hasCell(i)) {continue;}
+				const ofRectangle & r = atlas->getCell(i);
+				float scale = std::min(cell / r.width, cell / r.height);
+				float w = r.width * scale, h = r.height * scale;
+				float x = (i % columns) * cell + (cell - w) / 2;
+				float y = (i / columns) * cell - offset + (cell - h) / 2;
+				unsigned int v = mesh.getNumVertices();
+				mesh.addVertex({x, y, 0});
+				mesh.addVertex({x + w, y, 0});
+				mesh.addVertex({x + w, y + h, 0});
+				mesh.addVertex({x, y + h, 0});
+				mesh.addTexCoord(texture.getCoordFromPoint(r.x, r.y));
+				mesh.addTexCoord(texture.getCoordFromPoint(r.x + r.width, r.y));
+				mesh.addTexCoord(texture.getCoordFromPoint(r.x + r.width, r.y + r.height));
+				mesh.addTexCoord(texture.getCoordFromPoint(r.x, r.y + r.height));
+				mesh.addIndex(v);
+				mesh.addIndex(v + 1);
+				mesh.addIndex(v + 2);
+				mesh.addIndex(v);
+				mesh.addIndex(v + 2);
+				mesh.addIndex(v + 3);
+			}
+			dirty = false;
+		}
+
+		const StyleAtlas *atlas = nullptr; ///< thumbnail source
+		ofVboMesh mesh; ///< visible cell quads
+		bool dirty = true; ///< rebuild mesh?
+		float width = 1; ///< draw width
+		float height = 1; ///< draw height
+		int columns = 1; ///< number of columns
+		float cell = 1; ///< cell size
+		float offset = 0; ///< vertical scroll offset
+};
@@ -0,0 +1,104 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofThreadChannel.h"
+#include "StyleCache.h"
+
+/// asynchronous style image loading for images outside of the style library,
+/// ie. drag & drop or osc
+///
+/// images are decoded, downscaled & converted to model style input on a
+/// background thread & published when ready, recently loaded images are
+/// kept so loading them again is immediate
+class StyleLoader : public ofThread {
+
+	public:
+
+		static const std::size_t MAX_CACHED = 8; ///< max recently loaded styles
+
+		/// loaded style
+		struct Loaded {
+			std::shared_ptr<const Style> style = nullptr; ///< decoded style
+			cppflow::tensor tensor; ///< model style input
+		};
+
+		virtual ~StyleLoader() {
+			clear();
+		}
+
+		/// queue image path to load, starts thread if needed
+		void load(const std::string & path) {
+			if(!isThreadRunning()) {
+				startThread();
+			}
+			toLoad.send(path);
+		}
+
+		/// receive the latest loaded style, returns false if none is new
+		bool receive(Loaded & loaded) {
+			bool received = false;
+			while(this->loaded.tryReceive(loaded)) {
+				received = true;
+			}
+			return received;
+		}
+
+		/// stop loading
+		void clear() {
+			stopThread();
+			toLoad.close();
+			loaded.close();
+			waitForThread(false);
+		}
+
+	protected:
+
+		void threadedFunction() {
+			std::string path;
+			while(toLoad.receive(path)) {
+				int64_t mtime = 0;
+				uint64_t size = 0;
+				StyleManifest::stat(path, mtime, size);
+
+				// recently loaded & unchanged?
+				auto found = std::find_if(cached.begin(), cached.end(), [&](const Loaded & l) {
+					return l.style->path == path && l.style->mtime == mtime && l.style->size == size;
+				});
+				if(found != cached.end()) {
+					Loaded l = *found;
+					cached.erase(found);
+					cached.push_front(l);
+					loaded.send(l);
+					continue;
+				}
+
+				// decode, full res pixels are released after downscaling
+				Loaded l;
+				l.style = StyleCache::decode(path);
+				if(!l.style) {continue;}
+				l.tensor = ofxStyleTransfer::styleToTensor(l.style->pixels);
+				cached.push_front(l);
+				if(cached.size() > MAX_CACHED) {
+					cached.pop_back();
+				}
+				loaded.send(l);
+			}
+		}
+
+		ofThreadChannel<std::string> toLoad; ///< paths to load
+		ofThreadChannel<Loaded> loaded; ///< loaded styles
+		std::deque<Loaded> cached; ///< recently loaded, most recent first
+};
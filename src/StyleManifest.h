@@ -0,0 +1,320 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofFileUtils.h"
+#include "ofPixels.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <sys/stat.h>
+#ifndef TARGET_WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+/// decoded style image
+struct Style {
+	std::string path; ///< source image path
+	ofPixels pixels; ///< model-ready RGB pixels, STYLE_W x STYLE_H
+	ofPixels thumbnail; ///< downsampled RGB pixels for display, keeps aspect
+
+	// source file info
+	int64_t mtime = 0; ///< modification time
+	uint64_t size = 0; ///< size in bytes
+	uint64_t hash = 0; ///< content hash
+	int width = 0; ///< image width
+	int height = 0; ///< image height
+};
+
+/// persistent style library index with decoded style data
+///
+/// the file is memory mapped & styles reference the mapped pixel data
+/// directly, so the style directory is neither listed nor decoded on start
+/// & pixel data is not copied until used, opening still checks & indexes
+/// each entry by path
+///
+/// layout, native byte order:
+/// * Header
+/// * Entry * count
+/// * path strings, not null terminated
+/// * pixel data: style pixels & thumbnail pixels per entry, RGB
+class StyleManifest {
+
+	public:
+
+		static const uint32_t VERSION = 1; ///< file format version
+
+		/// file header
+		struct Header {
+			char magic[8]; ///< "STYLMAN"
+			uint32_t version; ///< file format version
+			uint32_t count; ///< number of entries
+			uint32_t styleWidth; ///< style pixels width
+			uint32_t styleHeight; ///< style pixels height
+			uint64_t stringsOffset; ///< path strings offset in bytes
+			uint64_t dataOffset; ///< pixel data offset in bytes
+		};
+
+		/// per style entry
+		struct Entry {
+			uint64_t pathOffset; ///< path offset in the strings block
+			uint32_t pathLength; ///< path length in bytes
+			uint32_t width; ///< source image width
+			uint32_t height; ///< source image height
+			uint32_t thumbWidth; ///< thumbnail width
+			uint32_t thumbHeight; ///< thumbnail height
+			uint32_t reserved;
+			int64_t mtime; ///< source file modification time
+			uint64_t size; ///< source file size in bytes
+			uint64_t hash; ///< source file content hash
+			uint64_t styleOffset; ///< style pixels offset in the data block
+			uint64_t thumbOffset; ///< thumbnail pixels offset in the data block
+		};
+
+		StyleManifest() {}
+		StyleManifest(const StyleManifest &) = delete;
+		StyleManifest & operator=(const StyleManifest &) = delete;
+		virtual ~StyleManifest() {close();}
+
+		/// open and map manifest file, returns false if missing or invalid
+		bool open(const std::string & path, int styleWidth, int styleHeight) {
+			close();
+			std::string absPath = ofToDataPath(path, true);
+		#ifdef TARGET_WIN32
+			buffer = ofBufferFromFile(absPath, true);
+			data = buffer.getData();
+			length = buffer.size();
+		#else
+			int fd = ::open(absPath.c_str(), O_RDONLY);
+			if(fd < 0) {return false;}
+			struct stat st;
+			if(fstat(fd, &st) == 0 && st.st_size > 0) {
+				void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(mapped != MAP_FAILED) {
+					data = (char *)mapped;
+					length = st.st_size;
+				}
+			}
+			::close(fd);
+		#endif
+			if(!validate(styleWidth, styleHeight)) {
+				ofLogWarning("StyleManifest") << "ignoring invalid manifest " << path;
+				close();
+				return false;
+			}
+			for(std::size_t i = 0; i < size(); ++i) {
+				index[getPath(i)] = i;
+			}
+			return true;
+		}
+
+		/// unmap manifest file, styles from getStyle() must not be used after
+		void close() {
+		#ifdef TARGET_WIN32
+			buffer.clear();
+		#else
+			if(data) {munmap(data, length);}
+		#endif
+			data = nullptr;
+			length = 0;
+			index.clear();
+		}
+
+		/// returns true if a manifest file is open
+		bool isOpen() const {return data != nullptr;}
+
+		/// returns number of entries
+		std::size_t size() const {
+			return data ? header()->count : 0;
+		}
+
+		/// returns entry by index
+		const Entry & getEntry(std::size_t i) const {
+			return ((const Entry *)(data + sizeof(Header)))[i];
+		}
+
+		/// returns entry path by index
+		std::string getPath(std::size_t i) const {
+			const Entry & e = getEntry(i);
+			return std::string(data + header()->stringsOffset + e.pathOffset, e.pathLength);
+		}
+
+		/// returns all entry paths in order
+		std::vector<std::string> getPaths() const {
+			std::vector<std::string> paths;
+			for(std::size_t i = 0; i < size(); ++i) {
+				paths.push_back(getPath(i));
+			}
+			return paths;
+		}
+
+		/// returns entry index by path or -1 if not found
+		int find(const std::string & path) const {
+			auto found = index.find(path);
+			return (found != index.end() ? found->second : -1);
+		}
+
+		/// returns entry index by content hash & size or -1 if not found
+		int findHash(uint64_t hash, uint64_t size) const {
+			for(std::size_t i = 0; i < this->size(); ++i) {
+				if(getEntry(i).hash == hash && getEntry(i).size == size) {return i;}
+			}
+			return -1;
+		}
+
+		/// returns style by index, pixels reference the mapped data without
+		/// copying & are valid until the manifest is closed
+		std::shared_ptr<Style> getStyle(std::size_t i) const {
+			const Entry & e = getEntry(i);
+			char *pixels = data + header()->dataOffset;
+			auto style = std::make_shared<Style>();
+			style->path = getPath(i);
+			style->pixels.setFromExternalPixels((unsigned char *)(pixels + e.styleOffset),
+				header()->styleWidth, header()->styleHeight, OF_PIXELS_RGB);
+			style->thumbnail.setFromExternalPixels((unsigned char *)(pixels + e.thumbOffset),
+				e.thumbWidth, e.thumbHeight, OF_PIXELS_RGB);
+			style->mtime = e.mtime;
+			style->size = e.size;
+			style->hash = e.hash;
+			style->width = e.width;
+			style->height = e.height;
+			return style;
+		}
+
+		/// write manifest file for styles, null styles are skipped
+		/// writes to a temp file first so an open manifest is not affected
+		static bool write(const std::string & path, int styleWidth, int styleHeight,
+		                  const std::vector<std::shared_ptr<const Style>> & styles) {
+			std::vector<const Style *> valid;
+			for(auto & style : styles) {
+				if(style) {valid.push_back(style.get());}
+			}
+
+			// entries & offsets
+			std::vector<Entry> entries(valid.size());
+			uint64_t strings = 0, pixels = 0;
+			for(std::size_t i = 0; i < valid.size(); ++i) {
+				const Style & s = *valid[i];
+				Entry & e = entries[i];
+				std::memset(&e, 0, sizeof(Entry));
+				e.pathOffset = strings;
+				e.pathLength = s.path.size();
+				e.width = s.width;
+				e.height = s.height;
+				e.thumbWidth = s.thumbnail.getWidth();
+				e.thumbHeight = s.thumbnail.getHeight();
+				e.mtime = s.mtime;
+				e.size = s.size;
+				e.hash = s.hash;
+				e.styleOffset = pixels;
+				pixels += styleWidth * styleHeight * 3;
+				e.thumbOffset = pixels;
+				pixels += e.thumbWidth * e.thumbHeight * 3;
+				strings += e.pathLength;
+			}
+			Header h;
+			std::memset(&h, 0, sizeof(Header));
+			std::strncpy(h.magic, "STYLMAN", sizeof(h.magic));
+			h.version = VERSION;
+			h.count = entries.size();
+			h.styleWidth = styleWidth;
+			h.styleHeight = styleHeight;
+			h.stringsOffset = sizeof(Header) + entries.size() * sizeof(Entry);
+			h.dataOffset = h.stringsOffset + strings;
+
+			// write
+			std::string absPath = ofToDataPath(path, true);
+			std::string tmpPath = absPath + ".tmp";
+			std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+			if(!file.is_open()) {
+				ofLogWarning("StyleManifest") << "could not write " << path;
+				return false;
+			}
+			file.write((const char *)&h, sizeof(Header));
+			file.write((const char *)entries.data(), entries.size() * sizeof(Entry));
+			for(auto s : valid) {
+				file.write(s->path.data(), s->path.size());
+			}
+			for(auto s : valid) {
+				file.write((const char *)s->pixels.getData(), styleWidth * styleHeight * 3);
+				file.write((const char *)s->thumbnail.getData(), s->thumbnail.size());
+			}
+			file.close();
+			if(file.fail() || std::rename(tmpPath.c_str(), absPath.c_str()) != 0) {
+				ofLogWarning("StyleManifest") << "could not write " << path;
+				std::remove(tmpPath.c_str());
+				return false;
+			}
+			return true;
+		}
+
+		/// get modification time & size of a file, returns false on error
+		static bool stat(const std::string & path, int64_t & mtime, uint64_t & size) {
+			struct stat st;
+			if(::stat(ofToDataPath(path, true).c_str(), &st) != 0) {return false;}
+			mtime = st.st_mtime;
+			size = st.st_size;
+			return true;
+		}
+
+		/// 64 bit FNV-1a content hash
+		static uint64_t hash(const char *bytes, std::size_t size) {
+			uint64_t h = 14695981039346656037ULL;
+			for(std::size_t i = 0; i < size; ++i) {
+				h ^= (unsigned char)bytes[i];
+				h *= 1099511628211ULL;
+			}
+			return h;
+		}
+
+	protected:
+
+		const Header * header() const {return (const Header *)data;}
+
+		// check header & bounds
+		bool validate(int styleWidth, int styleHeight) {
+			if(!data || length < sizeof(Header)) {return false;}
+			const Header *h = header();
+			if(std::strncmp(h->magic, "STYLMAN", sizeof(h->magic)) != 0 ||
+			   h->version != VERSION ||
+			   h->styleWidth != (uint32_t)styleWidth || h->styleHeight != (uint32_t)styleHeight ||
+			   h->stringsOffset != sizeof(Header) + (uint64_t)h->count * sizeof(Entry) ||
+			   h->dataOffset < h->stringsOffset || h->dataOffset > length) {
+				return false;
+			}
+			uint64_t stringsSize = h->dataOffset - h->stringsOffset;
+			uint64_t dataSize = length - h->dataOffset;
+			uint64_t styleSize = (uint64_t)styleWidth * styleHeight * 3;
+			for(std::size_t i = 0; i < h->count; ++i) {
+				const Entry & e = getEntry(i);
+				if(e.pathOffset + e.pathLength > stringsSize ||
+				   e.styleOffset + styleSize > dataSize ||
+				   e.thumbOffset + (uint64_t)e.thumbWidth * e.thumbHeight * 3 > dataSize) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		char *data = nullptr; ///< mapped file data
+		std::size_t length = 0; ///< mapped file length
+	#ifdef TARGET_WIN32
+		ofBuffer buffer; ///< file data, no mmap
+	#endif
+		std::unordered_map<std::string, std::size_t> index; ///< entry index by path
+};
@@ -0,0 +1,186 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "StyleCache.h"
+
+#include <condition_variable>
+#include <numeric>
+#include <random>
+
+/// look-ahead style order for automatic style changes
+///
+/// the upcoming style is decoded & converted to model style input on a
+/// background thread, so switching to it only swaps in the prepared data
+class StyleScheduler : public ofThread {
+
+	public:
+
+		/// style order
+		enum Order {
+			ORDER_SEQUENTIAL, ///< library order
+			ORDER_SHUFFLE ///< random order, each style once per round
+		};
+
+		/// style ready to be applied
+		struct Prepared {
+			std::size_t index = 0; ///< style library index
+			std::shared_ptr<const Style> style = nullptr; ///< nullptr if not ready in time
+			cppflow::tensor tensor; ///< model style input
+		};
+
+		virtual ~StyleScheduler() {
+			clear();
+		}
+
+		/// set style library & current index, starts preparing the upcoming
+		/// style in the background
+		void setup(StyleCache & cache, std::size_t count, std::size_t current,
+		           Order order=ORDER_SEQUENTIAL) {
+			clear();
+			if(count == 0) {return;}
+			std::lock_guard<std::mutex> lock(mutex);
+			this->cache = &cache;
+			this->order = order;
+			sequence.resize(count);
+			std::iota(sequence.begin(), sequence.end(), 0);
+			position = 0;
+			if(order == ORDER_SHUFFLE) {
+				shuffle(current);
+			}
+			else {
+				position = (current + 1) % count;
+			}
+			prepared = nullptr;
+			startThread();
+		}
+
+		/// stop preparing
+		void clear() {
+			stopThread();
+			{
+				std::lock_guard<std::mutex> lock(mutex); // don't miss the wake up
+				condition.notify_all();
+			}
+			waitForThread(false);
+			std::lock_guard<std::mutex> lock(mutex);
+			sequence.clear();
+			prepared = nullptr;
+		}
+
+		/// set current index after a manual style change, sequential order
+		/// continues from here, shuffle order skips index if upcoming
+		void setCurrent(std::size_t index) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(sequence.empty() || index >= sequence.size()) {return;}
+			std::size_t upcoming = sequence[position];
+			if(order == ORDER_SEQUENTIAL) {
+				position = (index + 1) % sequence.size();
+			}
+			else if(upcoming == index) {
+				advance();
+			}
+			if(sequence[position] != upcoming) {
+				condition.notify_all();
+			}
+		}
+
+		/// returns upcoming style index
+		std::size_t getUpcoming() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return (sequence.empty() ? 0 : sequence[position]);
+		}
+
+		/// take upcoming style & advance, style is nullptr if it was not
+		/// prepared in time, returns nullptr if not set up
+		std::shared_ptr<const Prepared> next() {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(sequence.empty()) {return nullptr;}
+			std::shared_ptr<const Prepared> ret = prepared;
+			if(!ret || ret->index != sequence[position]) {
+				auto unprepared = std::make_shared<Prepared>();
+				unprepared->index = sequence[position];
+				ret = unprepared;
+			}
+			prepared = nullptr;
+			advance();
+			condition.notify_all();
+			return ret;
+		}
+
+	protected:
+
+		// move to the next position, reshuffles after each round
+		void advance() {
+			std::size_t last = sequence[position];
+			position++;
+			if(position >= sequence.size()) {
+				position = 0;
+				if(order == ORDER_SHUFFLE) {
+					shuffle(last);
+				}
+			}
+		}
+
+		// shuffle order, avoids starting with the given index
+		void shuffle(std::size_t avoid) {
+			std::shuffle(sequence.begin(), sequence.end(), random);
+			if(sequence.size() > 1 && sequence.front() == avoid) {
+				std::swap(sequence.front(), sequence.back());
+			}
+			position = 0;
+		}
+
+		void threadedFunction() {
+			std::size_t failed = 0;
+			while(isThreadRunning()) {
+				std::size_t index;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [this] {
+						return !isThreadRunning() ||
+						       (!prepared || prepared->index != sequence[position]);
+					});
+					if(!isThreadRunning()) {break;}
+					index = sequence[position];
+				}
+				auto p = std::make_shared<Prepared>();
+				p->index = index;
+				p->style = cache->load(index); // decodes now if not cached yet
+				if(p->style) {
+					p->tensor = ofxStyleTransfer::styleToTensor(p->style->pixels);
+				}
+				std::unique_lock<std::mutex> lock(mutex);
+				if(!sequence.empty() && sequence[position] == index) {
+					if(!p->style) {
+						// unreadable, skip
+						if(++failed >= sequence.size()) {break;} // none readable
+						advance();
+						continue;
+					}
+					failed = 0;
+					prepared = p;
+				}
+			}
+		}
+
+		StyleCache *cache = nullptr; ///< style source
+		Order order = ORDER_SEQUENTIAL; ///< style order
+		std::vector<std::size_t> sequence; ///< style indices in order
+		std::size_t position = 0; ///< upcoming sequence position
+		std::shared_ptr<const Prepared> prepared = nullptr; ///< prepared upcoming style
+		std::condition_variable condition; ///< wakes the thread to prepare
+		std::mt19937 random {std::random_device{}()}; ///< shuffle generator
+};
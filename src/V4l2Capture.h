@@ -0,0 +1,375 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofConstants.h"
+#include "ofTexture.h"
+#include "ofLog.h"
+
+#ifdef TARGET_LINUX
+
+#include "Yuv.h"
+#include "MjpegDecoder.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Video4Linux2 camera capture using memory mapped driver buffers
+//
+// YUYV or NV12 frames are used in place from the driver buffer & converted in
+// one pass to the model's normalized float RGB input, mirroring included,
+// 8 bit RGB pixels & the texture are only converted when requested
+//
+// MJPEG, which many USB cameras require for full rate at high resolutions, is
+// decoded by a pool of MjpegDecoder threads at the decode size instead, the
+// driver buffer is given back as soon as the compressed frame is copied
+//
+// linux only
+class V4l2Capture {
+
+	public:
+
+		static const unsigned int BUFFER_COUNT = 4; ///< driver buffers
+		static const std::size_t MJPEG_THREADS = 3; ///< mjpeg decoder threads
+
+		V4l2Capture() {}
+		V4l2Capture(const V4l2Capture &) = delete;
+		V4l2Capture & operator=(const V4l2Capture &) = delete;
+		virtual ~V4l2Capture() {close();}
+
+		/// open device, ie. "/dev/video0", with desired size & frame rate,
+		/// captures YUYV or NV12 or, if mjpeg is true, MJPEG, returns false on
+		/// error or if the device does not provide the format
+		bool open(const std::string & device, int width, int height, int fps=30,
+		          bool mjpeg=false) {
+			close();
+			fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+			if(fd < 0) {
+				ofLogError("V4l2Capture") << "could not open " << device;
+				return false;
+			}
+			if(!setFormat(width, height, mjpeg) || !setRate(fps) || !mapBuffers() || !start()) {
+				ofLogError("V4l2Capture") << "could not start capture on " << device;
+				close();
+				return false;
+			}
+			if(isCompressed()) {
+				decoder.setup(MJPEG_THREADS, decodeSize.width, decodeSize.height);
+			}
+			ofLogVerbose("V4l2Capture") << device << " " << this->width << "x" << this->height
+				<< (pixelFormat == V4L2_PIX_FMT_YUYV ? " yuyv" :
+				   (pixelFormat == V4L2_PIX_FMT_NV12 ? " nv12" : " mjpeg"));
+			return true;
+		}
+
+		void close() {
+			if(fd >= 0) {
+				v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+				ioctl(fd, VIDIOC_STREAMOFF, &type);
+			}
+			decoder.close();
+			for(auto & buffer : buffers) {
+				munmap(buffer.data, buffer.length);
+			}
+			buffers.clear();
+			if(fd >= 0) {::close(fd);}
+			fd = -1;
+			held = -1;
+			pixelFormat = 0;
+			newFrame = false;
+			pixels.clear();
+			floatPixels.clear();
+			texture.clear();
+		}
+
+		/// returns true if capturing
+		bool isOpen() const {return fd >= 0;}
+
+		/// take the newest captured frame without waiting, older frames are
+		/// given back to the driver
+		void update() {
+			newFrame = false;
+			if(fd < 0) {return;}
+			v4l2_buffer buffer;
+			if(isCompressed()) {
+				while(dequeue(buffer)) {
+					if(held >= 0) {enqueue(held);}
+					held = buffer.index;
+					sequence = buffer.sequence;
+					size = buffer.bytesused;
+				}
+				if(held >= 0) { // newest only, dropped if all threads are busy
+					decoder.submit((const uint8_t *)buffers[held].data, size, sequence);
+					enqueue(held);
+					held = -1;
+				}
+				decoder.update();
+				newFrame = decoder.isFrameNew();
+				textureDirty = textureDirty || newFrame;
+				return;
+			}
+			while(dequeue(buffer)) {
+				if(held >= 0) {enqueue(held);}
+				held = buffer.index;
+				newFrame = true;
+			}
+			if(newFrame) {
+				pixelsDirty = floatDirty = textureDirty = true;
+			}
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		/// set mirroring, applied during conversion
+		void setMirror(bool horz, bool vert) {
+			if(horz != mirror || vert != flip) {
+				mirror = horz;
+				flip = vert;
+				pixelsDirty = floatDirty = textureDirty = true;
+				decoder.setMirror(horz, vert);
+			}
+		}
+
+		/// min MJPEG decode size, keeping aspect ratio, 0 for capture size,
+		/// set before open(), YUYV & NV12 frames are always full size
+		void setDecodeSize(int width, int height) {
+			decodeSize.width = width;
+			decodeSize.height = height;
+		}
+
+		/// returns true if capturing MJPEG, getFloatPixels() is then unused
+		bool isCompressed() const {return pixelFormat == V4L2_PIX_FMT_MJPEG;}
+
+		int getWidth() const {
+			return isCompressed() && hasFrame() ? decoder.getPixels().getWidth() : width;
+		}
+		int getHeight() const {
+			return isCompressed() && hasFrame() ? decoder.getPixels().getHeight() : height;
+		}
+
+		/// current frame as 8 bit RGB, converted on first request
+		const ofPixels & getPixels() {
+			if(isCompressed()) {return decoder.getPixels();}
+			if(pixelsDirty && held >= 0) {
+				pixels.allocate(width, height, OF_PIXELS_RGB);
+				convert(pixels.getData());
+				pixelsDirty = false;
+			}
+			return pixels;
+		}
+
+		/// current frame as normalized 0-1 float RGB model input, converted on
+		/// first request
+		const ofFloatPixels & getFloatPixels() {
+			if(floatDirty && held >= 0) {
+				floatPixels.allocate(width, height, OF_PIXELS_RGB);
+				convert(floatPixels.getData());
+				floatDirty = false;
+			}
+			return floatPixels;
+		}
+
+		void draw(float x, float y, float w, float h) {
+			if(!hasFrame()) {return;}
+			if(textureDirty) {
+				texture.loadData(getPixels());
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+	protected:
+
+		/// mapped driver buffer
+		struct Buffer {
+			void *data = nullptr;
+			std::size_t length = 0;
+		};
+
+		// returns true if there is a current frame
+		bool hasFrame() const {
+			return isCompressed() ? decoder.getPixels().isAllocated() : held >= 0;
+		}
+
+		// request YUYV, then NV12 or MJPEG only, driver may adjust the size
+		bool setFormat(int width, int height, bool mjpeg) {
+			std::vector<uint32_t> formats = {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12};
+			if(mjpeg) {formats = {V4L2_PIX_FMT_MJPEG};}
+			for(uint32_t format : formats) {
+				v4l2_format fmt = {};
+				fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+				fmt.fmt.pix.width = width;
+				fmt.fmt.pix.height = height;
+				fmt.fmt.pix.pixelformat = format;
+				fmt.fmt.pix.field = V4L2_FIELD_NONE;
+				if(xioctl(VIDIOC_S_FMT, &fmt) && fmt.fmt.pix.pixelformat == format) {
+					this->width = fmt.fmt.pix.width;
+					this->height = fmt.fmt.pix.height;
+					stride = fmt.fmt.pix.bytesperline;
+					pixelFormat = format;
+					fullRange = (fmt.fmt.pix.quantization == V4L2_QUANTIZATION_FULL_RANGE);
+					return true;
+				}
+			}
+			ofLogError("V4l2Capture") << "device provides " << (mjpeg ? "no mjpeg" : "neither yuyv nor nv12");
+			return false;
+		}
+
+		// request frame rate, not all drivers support this
+		bool setRate(int fps) {
+			v4l2_streamparm parm = {};
+			parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			parm.parm.capture.timeperframe.numerator = 1;
+			parm.parm.capture.timeperframe.denominator = fps;
+			xioctl(VIDIOC_S_PARM, &parm);
+			return true;
+		}
+
+		// request & map driver buffers
+		bool mapBuffers() {
+			v4l2_requestbuffers request = {};
+			request.count = BUFFER_COUNT;
+			request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			request.memory = V4L2_MEMORY_MMAP;
+			if(!xioctl(VIDIOC_REQBUFS, &request) || request.count < 2) {return false;}
+			for(unsigned int i = 0; i < request.count; ++i) {
+				v4l2_buffer buffer = {};
+				buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+				buffer.memory = V4L2_MEMORY_MMAP;
+				buffer.index = i;
+				if(!xioctl(VIDIOC_QUERYBUF, &buffer)) {return false;}
+				Buffer mapped;
+				mapped.length = buffer.length;
+				mapped.data = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE,
+				                   MAP_SHARED, fd, buffer.m.offset);
+				if(mapped.data == MAP_FAILED) {return false;}
+				buffers.push_back(mapped);
+			}
+			return true;
+		}
+
+		// queue all buffers & start streaming
+		bool start() {
+			for(unsigned int i = 0; i < buffers.size(); ++i) {
+				if(!enqueue(i)) {return false;}
+			}
+			v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			return xioctl(VIDIOC_STREAMON, &type);
+		}
+
+		// give buffer back to the driver
+		bool enqueue(unsigned int index) {
+			v4l2_buffer buffer = {};
+			buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buffer.memory = V4L2_MEMORY_MMAP;
+			buffer.index = index;
+			return xioctl(VIDIOC_QBUF, &buffer);
+		}
+
+		// take filled buffer from the driver, returns false if none is ready
+		bool dequeue(v4l2_buffer & buffer) {
+			buffer = {};
+			buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buffer.memory = V4L2_MEMORY_MMAP;
+			if(ioctl(fd, VIDIOC_DQBUF, &buffer) < 0) {
+				if(errno != EAGAIN) {
+					ofLogWarning("V4l2Capture") << "dequeue failed: " << strerror(errno);
+				}
+				return false;
+			}
+			return true;
+		}
+
+		// convert held buffer to packed RGB
+		template<typename T>
+		void convert(T *rgb) {
+			const uint8_t *src = (const uint8_t *)buffers[held].data;
+			if(pixelFormat == V4L2_PIX_FMT_YUYV) {
+				Yuv::yuyvToRgb(src, stride, width, height, fullRange, mirror, flip, rgb);
+			}
+			else {
+				Yuv::nv12ToRgb(src, stride, width, height, fullRange, mirror, flip, rgb);
+			}
+		}
+
+		// ioctl, retried if interrupted, returns false on error
+		bool xioctl(unsigned long request, void *arg) {
+			int ret;
+			do {ret = ioctl(fd, request, arg);} while(ret < 0 && errno == EINTR);
+			return ret >= 0;
+		}
+
+		int fd = -1; ///< device file descriptor
+		std::vector<Buffer> buffers; ///< mapped driver buffers
+		int held = -1; ///< dequeued buffer index of the current frame
+		int width = 0; ///< frame width
+		int height = 0; ///< frame height
+		int stride = 0; ///< bytes per line
+		uint32_t pixelFormat = 0; ///< YUYV, NV12, or MJPEG
+		bool fullRange = false; ///< full or limited range YUV?
+		bool mirror = false; ///< mirror horizontally?
+		bool flip = false; ///< flip vertically?
+		bool newFrame = false; ///< is the current frame new?
+		bool pixelsDirty = false; ///< do the RGB pixels need a conversion?
+		bool floatDirty = false; ///< do the float pixels need a conversion?
+		bool textureDirty = false; ///< does the texture need an upload?
+		ofPixels pixels; ///< 8 bit RGB, on request
+		ofFloatPixels floatPixels; ///< normalized float RGB model input
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		MjpegDecoder decoder; ///< mjpeg decoder threads
+		struct {
+			int width = 0;
+			int height = 0;
+		} decodeSize; ///< min mjpeg decode size, 0 for capture size
+		std::size_t size = 0; ///< compressed size of the held mjpeg frame
+		uint64_t sequence = 0; ///< driver sequence of the held mjpeg frame
+};
+
+#else
+
+// not supported on this platform, open() always fails
+class V4l2Capture {
+
+	public:
+
+		bool open(const std::string & device, int width, int height, int fps=30,
+		          bool mjpeg=false) {
+			ofLogError("V4l2Capture") << "v4l2 input is only supported on linux";
+			return false;
+		}
+		void close() {}
+		bool isOpen() const {return false;}
+		void update() {}
+		bool isFrameNew() const {return false;}
+		void setMirror(bool horz, bool vert) {}
+		void setDecodeSize(int width, int height) {}
+		bool isCompressed() const {return false;}
+		int getWidth() const {return 0;}
+		int getHeight() const {return 0;}
+		const ofPixels & getPixels() {return pixels;}
+		const ofFloatPixels & getFloatPixels() {return floatPixels;}
+		void draw(float x, float y, float w, float h) {}
+
+	protected:
+
+		ofPixels pixels;
+		ofFloatPixels floatPixels;
+};
+
+#endif
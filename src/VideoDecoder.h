@@ -0,0 +1,283 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include "ofThread.h"
+#include "ofThreadChannel.h"
+#include "ofTexture.h"
+#include "VideoPlayer.h"
+#include "SpscQueue.h"
+
+// VideoPlayer playlist decoded on its own thread
+//
+// frames are copied into a fixed pool of recycled pixel buffers & handed to
+// the main thread through a lock-free queue with their timestamps, so decoding
+// runs in parallel to rendering without per frame allocation & the current
+// frame is never overwritten by the next decode
+//
+// the texture is only uploaded when the frame is drawn
+class VideoDecoder : public ofThread {
+
+	public:
+
+		static const std::size_t POOL_SIZE = 4; ///< number of frame buffers
+
+		VideoDecoder() {
+			for(auto & pixels : pool) {
+				free.push(&pixels);
+			}
+		}
+
+		virtual ~VideoDecoder() {
+			close();
+		}
+
+		bool load(const std::vector<std::string> & paths) {
+			if(paths.empty()) {return false;}
+			if(!isThreadRunning()) {
+				commands = std::make_shared<ofThreadChannel<Command>>();
+				startThread();
+			}
+			generation++;
+			send({Command::LOAD, generation, 0, paths, decodeSize.width, decodeSize.height});
+			return true;
+		}
+
+		void close() {
+			stopThread();
+			if(commands) {commands->close();}
+			waitForThread(false);
+			commands = nullptr;
+
+			// thread stopped, safe to recycle all buffers
+			frames.reset();
+			free.reset();
+			for(auto & pixels : pool) {
+				free.push(&pixels);
+			}
+			current = Frame();
+			texture.clear();
+			newFrame = false;
+			stepRequested = false;
+		}
+
+		void update() {
+			newFrame = false;
+			Frame frame;
+			if(lockstep) { // next frame only when requested
+				while(stepRequested && frames.pop(frame)) {
+					if(frame.generation != generation) {free.push(frame.pixels); continue;}
+					present(frame);
+					stepRequested = false;
+				}
+			}
+			else { // latest frame, skip older
+				while(frames.pop(frame)) {
+					if(frame.generation != generation) {free.push(frame.pixels); continue;}
+					present(frame);
+				}
+			}
+		}
+
+		void draw(float x, float y) {
+			draw(x, y, getWidth(), getHeight());
+		}
+
+		void draw(float x, float y, float w, float h) {
+			if(!current.pixels) {return;}
+			if(textureDirty) {
+				texture.loadData(*current.pixels);
+				textureDirty = false;
+			}
+			texture.draw(x, y, w, h);
+		}
+
+		bool isFrameNew() const {return newFrame;}
+
+		void setPaused(bool paused) {
+			this->paused = paused;
+			send({Command::PAUSE, generation, (float)paused});
+		}
+		bool isPaused() const {return paused;}
+
+		void play() {
+			paused = false;
+			send({Command::PLAY, generation});
+		}
+		void stop() {
+			send({Command::STOP, generation});
+		}
+
+		bool isLoaded() const {return current.pixels != nullptr;}
+
+		void previousFrame() {
+			flush();
+			send({Command::PREVIOUS_FRAME, generation});
+			stepRequested = true;
+		}
+
+		void nextFrame() {
+			send({Command::NEXT_FRAME, generation});
+			stepRequested = true; // lockstep: show next in order
+		}
+
+		void previousVideo() {
+			flush();
+			send({Command::PREVIOUS_VIDEO, generation});
+		}
+
+		void nextVideo() {
+			flush();
+			send({Command::NEXT_VIDEO, generation});
+		}
+
+		/// enable lockstep playback, see VideoPlayer::setLockstep(), frames
+		/// are decoded ahead up to the pool size
+		void setLockstep(bool lockstep) {
+			this->lockstep = lockstep;
+			stepRequested = false;
+			send({Command::LOCKSTEP, generation, (float)lockstep});
+		}
+		bool getLockstep() const {return lockstep;}
+
+		/// show the next decoded frame in lockstep mode, ignored if paused
+		void step() {
+			if(!lockstep || paused) {return;}
+			stepRequested = true;
+		}
+
+		void setVolume(float v) {
+			send({Command::VOLUME, generation, v});
+		}
+
+		/// scale frames while decoding, see VideoPlayer::setDecodeSize(),
+		/// set before load()
+		void setDecodeSize(int width, int height) {
+			decodeSize.width = width;
+			decodeSize.height = height;
+		}
+
+		float getWidth() const {return current.pixels ? current.pixels->getWidth() : 0;}
+		float getHeight() const {return current.pixels ? current.pixels->getHeight() : 0;}
+
+		const ofPixels & getPixels() const {
+			static const ofPixels empty;
+			return current.pixels ? *current.pixels : empty;
+		}
+
+		/// returns current frame playback time in s
+		float getTime() const {return current.time;}
+
+		bool isLastFrame() {return current.last;}
+
+	protected:
+
+		/// decoded frame
+		struct Frame {
+			ofPixels *pixels = nullptr; ///< pool buffer
+			float time = 0; ///< presentation time in s
+			bool last = false; ///< last frame of the video?
+			unsigned int generation = 0; ///< frames from before a seek are stale
+		};
+
+		/// decoder thread command
+		struct Command {
+			enum Type {
+				LOAD, PLAY, STOP, PAUSE, LOCKSTEP, VOLUME,
+				NEXT_FRAME, PREVIOUS_FRAME, NEXT_VIDEO, PREVIOUS_VIDEO
+			} type;
+			unsigned int generation = 0; ///< stamped on frames decoded after
+			float value = 0; ///< pause, lockstep, or volume
+			std::vector<std::string> paths; ///< load only
+			int width = 0; ///< load only, decode width
+			int height = 0; ///< load only, decode height
+		};
+
+		void threadedFunction() {
+			VideoPlayer player; // created & destroyed on this thread
+			player.setUseTexture(false);
+			unsigned int decoding = 0; // current generation
+			Command command;
+			while(isThreadRunning()) {
+				while(commands->tryReceive(command)) {
+					decoding = command.generation;
+					switch(command.type) {
+						case Command::LOAD:
+							player.setDecodeSize(command.width, command.height);
+							player.load(command.paths);
+							break;
+						case Command::PLAY: player.play(); break;
+						case Command::STOP: player.stop(); break;
+						case Command::PAUSE: player.setPaused(command.value); break;
+						case Command::LOCKSTEP: player.setLockstep(command.value); break;
+						case Command::VOLUME: player.setVolume(command.value); break;
+						case Command::NEXT_FRAME: player.nextFrame(); break;
+						case Command::PREVIOUS_FRAME: player.previousFrame(); break;
+						case Command::NEXT_VIDEO: player.nextVideo(); break;
+						case Command::PREVIOUS_VIDEO: player.previousVideo(); break;
+					}
+				}
+				player.update();
+				if(player.isFrameNew()) {
+					Frame frame;
+					if(free.pop(frame.pixels)) { // otherwise drop, all buffers in use
+						// reuses the allocation if size & format match
+						*frame.pixels = player.getPixels();
+						frame.time = player.getTime();
+						frame.last = player.isLastFrame();
+						frame.generation = decoding;
+						frames.push(frame); // never full, pool size
+					}
+				}
+				if(player.getLockstep() && !free.empty()) {
+					player.step(); // decode ahead while buffers are free
+				}
+				sleep(1);
+			}
+		}
+
+		// show frame & recycle previous frame buffer
+		void present(const Frame & frame) {
+			if(current.pixels) {free.push(current.pixels);}
+			current = frame;
+			textureDirty = true;
+			newFrame = true;
+		}
+
+		// drop frames decoded ahead, ie. before a seek
+		void flush() {
+			generation++;
+		}
+
+		void send(Command && command) {
+			if(commands) {commands->send(std::move(command));}
+		}
+
+		std::array<ofPixels, POOL_SIZE> pool; ///< frame buffers
+		SpscQueue<ofPixels *, POOL_SIZE> free; ///< main -> decoder, unused buffers
+		SpscQueue<Frame, POOL_SIZE> frames; ///< decoder -> main, decoded frames
+		std::shared_ptr<ofThreadChannel<Command>> commands; ///< main -> decoder
+		Frame current; ///< current frame, held by main
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		unsigned int generation = 0; ///< current seek generation
+		struct {
+			int width = 0;
+			int height = 0;
+		} decodeSize; ///< decode size, 0 for video size
+		bool textureDirty = false; ///< does the texture need an upload?
+		bool newFrame = false; ///< is the current frame new?
+		bool paused = false; ///< is playback paused?
+		bool lockstep = false; ///< show frames by step() only?
+		bool stepRequested = false; ///< show next decoded frame in lockstep?
+};
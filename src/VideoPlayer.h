@@ -15,80 +15,152 @@
 
 #include "ofBaseTypes.h"
 #include "ofUtils.h"
+#include "ScaledVideoPlayer.h"
 
 // wrap ofVideoPlayer with simple path playlist
+//
+// the next video is loaded & prerolled by a second player in the background
+// while the current video plays, so the playlist advances without a stall
+//
+// the texture is only uploaded when the frame is drawn
 class VideoPlayer {
 
 	public:
 
+		VideoPlayer() {
+			players[0].setUseTexture(false); // uploaded in draw() instead
+			players[1].setUseTexture(false);
+		}
+
 		bool load(const std::vector<std::string> & paths) {
 			if(paths.empty()) {return false;}
 			this->paths = paths;
-			setVideo(this->paths[index]);
+			if(index >= paths.size()) {index = 0;}
+			preloadIndex = NONE;
+			setVideo(index);
 			return true;
 		}
 
 		void close() {
-			player.close();
+			players[0].close();
+			players[1].close();
+			preloadIndex = NONE;
+			texture.clear();
 		}
 
 		void update() {
-			player.update();
-			if(player.getIsMovieDone()) {
+			if(preloadIndex != NONE) {
+				preload().update(); // finish async load
+			}
+			player().update();
+			if(player().isFrameNew()) {
+				stepping = false;
+				textureDirty = true;
+			}
+			if(player().getIsMovieDone()) {
 				nextVideo();
 			}
-			else if(player.isFrameNew() && newVideo) {
+			else if(player().isFrameNew() && newVideo) {
 				newVideo = false;
 			}
 		}
 
 		void draw(float x, float y) {
-			player.draw(x, y);
+			draw(x, y, getWidth(), getHeight());
 		}
 
 		void draw(float x, float y, float w, float h) {
-			player.draw(x, y, w, h);
+			if(textureDirty && useTexture && getPixels().isAllocated()) {
+				texture.loadData(getPixels());
+				textureDirty = false;
+			}
+			if(texture.isAllocated()) {texture.draw(x, y, w, h);}
 		}
 
 		bool isFrameNew() const {
-			return player.isFrameNew();
+			return player().isFrameNew();
 		}
 
 		void setPaused(bool paused) {
-			player.setPaused(paused);
+			this->paused = paused;
+			player().setPaused(paused || lockstep);
 		}
 
 		bool isPaused() const {
-			return player.isPaused();
+			return (lockstep ? paused : player().isPaused());
+		}
+
+		/// enable lockstep playback: the video is paused & only advanced by
+		/// step(), ie. when the consumer is ready for the next frame
+		void setLockstep(bool lockstep) {
+			this->lockstep = lockstep;
+			stepping = false;
+			player().setPaused(paused || lockstep);
+		}
+		bool getLockstep() const {return lockstep;}
+
+		/// advance to the next frame in lockstep mode, ignored if paused or
+		/// the previous step's frame has not arrived yet
+		void step() {
+			if(!lockstep || paused || stepping) {return;}
+			stepping = true;
+			if(player().getCurrentFrame() >= player().getTotalNumFrames() - 1) {
+				nextVideo();
+			}
+			else {
+				player().nextFrame();
+			}
 		}
 
 		void play() {
-			player.play();
+			paused = false;
+			player().play();
+			if(lockstep) {player().setPaused(true);}
 		}
 		void stop() {
-			player.stop();
+			player().stop();
 		}
 
-		bool isLoaded() const {return player.isLoaded();}
-		bool isPlaying() const {return player.isPlaying();}
+		bool isLoaded() const {return player().isLoaded();}
+		bool isPlaying() const {return player().isPlaying();}
 
 		void previousFrame() {
-			player.previousFrame();
+			player().previousFrame();
 		}
 
 		void nextFrame() {
-			player.nextFrame();
+			player().nextFrame();
 		}
 
-		float getWidth() const {return player.getWidth();}
-		float getHeight() const {return player.getHeight();}
+		float getWidth() const {return player().getWidth();}
+		float getHeight() const {return player().getHeight();}
 
-		const ofPixels & getPixels() const {return player.getPixels();}
+		const ofPixels & getPixels() const {return player().getPixels();}
 
-		bool isLastFrame() {return player.getCurrentFrame() == player.getTotalNumFrames();}
+		bool isLastFrame() {return player().getCurrentFrame() == player().getTotalNumFrames();}
 
 		bool isVideoNew() {return newVideo;}
 
+		/// returns current playback time in s
+		float getTime() const {return player().getPosition() * player().getDuration();}
+
+		/// scale frames while decoding to width & height, ie. the model input
+		/// size, set before load(), linux only: ignored on other platforms
+		void setDecodeSize(int width, int height) {
+		#ifdef TARGET_LINUX
+			if(width <= 0 || height <= 0) {return;}
+			for(auto & player : players) {
+				player.setPlayer(std::make_shared<ScaledVideoPlayer>(width, height));
+			}
+		#endif
+		}
+
+		/// set whether to upload frames to textures when drawn, disable to
+		/// decode off the main thread
+		void setUseTexture(bool use) {
+			useTexture = use;
+		}
+
 		void previousVideo() {
 			if(index == 0) {
 				index = paths.size()-1;
@@ -96,7 +168,7 @@ class VideoPlayer {
 			else {
 				index--;
 			}
-			setVideo(paths[index]);
+			setVideo(index);
 		}
 
 		void nextVideo() {
@@ -104,24 +176,63 @@ class VideoPlayer {
 			if(index >= paths.size()) {
 				index = 0;
 			}
-			setVideo(paths[index]);
+			setVideo(index);
 		}
 
-		void setVolume(float v) {player.setVolume(v);}
+		void setVolume(float v) {
+			volume = v;
+			players[0].setVolume(v);
+			players[1].setVolume(v);
+		}
 
 	protected:
 
-		void setVideo(std::string & path) {
-			bool wasPlaying = player.isPlaying();
-			if(!player.load(path)) {
+		static const std::size_t NONE = (std::size_t)-1; ///< no preload
+
+		// switch to video by path index, uses the preloaded player if ready,
+		// otherwise loads synchronously
+		void setVideo(std::size_t index) {
+			bool wasPlaying = player().isPlaying();
+			if(preloadIndex == index && preload().isLoaded()) {
+				player().stop();
+				current = 1 - current;
+			}
+			else if(!player().load(paths[index])) {
 				return;
 			}
-			if(wasPlaying) {player.play();}
+			player().setVolume(volume);
+			if(wasPlaying) {
+				player().play();
+				if(paused || lockstep) {player().setPaused(true);}
+			}
+			stepping = false;
 			newVideo = true;
+			preloadNext();
 		}
 
+		// start loading the next video into the other player
+		void preloadNext() {
+			preloadIndex = NONE;
+			if(paths.size() < 2) {return;}
+			preloadIndex = (index + 1) % paths.size();
+			preload().loadAsync(paths[preloadIndex]);
+		}
+
+		ofVideoPlayer & player() {return players[current];}
+		const ofVideoPlayer & player() const {return players[current];}
+		ofVideoPlayer & preload() {return players[1 - current];}
+
 		std::vector<std::string> paths; ///< image file paths, min 1 required
 		std::size_t index = 0; ///< image path index
-		ofVideoPlayer player; ///< current video
+		ofVideoPlayer players[2]; ///< current & preloading next video
+		std::size_t current = 0; ///< current video player index
+		std::size_t preloadIndex = NONE; ///< path index being preloaded
+		float volume = 1; ///< volume for both players
+		bool paused = false; ///< is playback paused by the user?
+		bool lockstep = false; ///< advance by step() only?
+		bool stepping = false; ///< waiting for the frame of the last step?
 		bool newVideo = false; ///< has a new video been loaded?
+		ofTexture texture; ///< current frame texture, uploaded on draw
+		bool textureDirty = false; ///< does the texture need an upload?
+		bool useTexture = true; ///< upload frames when drawn?
 };
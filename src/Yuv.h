@@ -0,0 +1,130 @@
+/*
+ * Styler
+ *
+ * Copyright (c) 2023 ZKM | Hertz-Lab
+ * Dan Wilcox <dan.wilcox@zkm.de>
+ *
+ * GPL v3 License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * This code has been developed at ZKM | Hertz-Lab as part of „The Intelligent
+ * Museum“ generously funded by the German Federal Cultural Foundation.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/// YUV -> RGB conversion, BT.601
+///
+/// 8 bit RGB output is integer fixed point, float RGB output is normalized to
+/// 0-1 for the model input, limited (16-235) or full (0-255) range
+class Yuv {
+
+	public:
+
+		/// convert planar YUV 4:2:0 or 4:4:4 to packed RGB, chroma is
+		/// subsampled by chromaShift: 1 for 4:2:0, 0 for 4:4:4
+		static void planarToRgb(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+		                        int width, int height, int chromaShift, bool fullRange,
+		                        uint8_t *rgb) {
+			int chromaWidth = (width + chromaShift) >> chromaShift;
+			for(int row = 0; row < height; ++row) {
+				const uint8_t *yRow = y + row * width;
+				const uint8_t *uRow = u + (row >> chromaShift) * chromaWidth;
+				const uint8_t *vRow = v + (row >> chromaShift) * chromaWidth;
+				uint8_t *out = rgb + row * width * 3;
+				for(int col = 0; col < width; ++col) {
+					toRgb(yRow[col], uRow[col >> chromaShift], vRow[col >> chromaShift],
+					      fullRange, out);
+					out += 3;
+				}
+			}
+		}
+
+		/// convert packed YUYV 4:2:2 rows to packed RGB in one pass,
+		/// optionally mirrored horizontally and/or flipped vertically,
+		/// T is uint8_t for 8 bit or float for normalized 0-1 RGB
+		template<typename T>
+		static void yuyvToRgb(const uint8_t *src, int stride, int width, int height,
+		                      bool fullRange, bool mirror, bool flip, T *rgb) {
+			for(int row = 0; row < height; ++row) {
+				const uint8_t *in = src + row * stride;
+				T *out = rgb + (flip ? height - 1 - row : row) * width * 3;
+				for(int col = 0; col < width; col += 2, in += 4) {
+					int u = in[1], v = in[3];
+					toRgb(in[0], u, v, fullRange, out + index(col, width, mirror));
+					if(col + 1 < width) {
+						toRgb(in[2], u, v, fullRange, out + index(col + 1, width, mirror));
+					}
+				}
+			}
+		}
+
+		/// convert NV12 4:2:0, Y plane followed by interleaved UV plane, to
+		/// packed RGB in one pass, see yuyvToRgb()
+		template<typename T>
+		static void nv12ToRgb(const uint8_t *src, int stride, int width, int height,
+		                      bool fullRange, bool mirror, bool flip, T *rgb) {
+			const uint8_t *uv = src + stride * height;
+			for(int row = 0; row < height; ++row) {
+				const uint8_t *y = src + row * stride;
+				const uint8_t *c = uv + (row >> 1) * stride;
+				T *out = rgb + (flip ? height - 1 - row : row) * width * 3;
+				for(int col = 0; col < width; ++col) {
+					int chroma = col & ~1;
+					toRgb(y[col], c[chroma], c[chroma + 1], fullRange, out + index(col, width, mirror));
+				}
+			}
+		}
+
+		/// convert one YUV pixel to RGB
+		static inline void toRgb(int y, int u, int v, bool fullRange, uint8_t *rgb) {
+			int c, d = u - 128, e = v - 128;
+			if(fullRange) {
+				c = y << 8;
+				rgb[0] = clamp((c + 359 * e + 128) >> 8);
+				rgb[1] = clamp((c - 88 * d - 183 * e + 128) >> 8);
+				rgb[2] = clamp((c + 454 * d + 128) >> 8);
+			}
+			else {
+				c = (y - 16) * 298;
+				rgb[0] = clamp((c + 409 * e + 128) >> 8);
+				rgb[1] = clamp((c - 100 * d - 208 * e + 128) >> 8);
+				rgb[2] = clamp((c + 516 * d + 128) >> 8);
+			}
+		}
+
+		/// convert one YUV pixel to normalized 0-1 RGB
+		static inline void toRgb(int y, int u, int v, bool fullRange, float *rgb) {
+			float c, d = u - 128, e = v - 128;
+			float r, g, b;
+			if(fullRange) {
+				c = y;
+				r = c + 1.402f * e;
+				g = c - 0.344f * d - 0.714f * e;
+				b = c + 1.772f * d;
+			}
+			else {
+				c = (y - 16) * 1.164f;
+				r = c + 1.596f * e;
+				g = c - 0.392f * d - 0.813f * e;
+				b = c + 2.017f * d;
+			}
+			rgb[0] = std::min(std::max(r * (1 / 255.f), 0.f), 1.f);
+			rgb[1] = std::min(std::max(g * (1 / 255.f), 0.f), 1.f);
+			rgb[2] = std::min(std::max(b * (1 / 255.f), 0.f), 1.f);
+		}
+
+	protected:
+
+		// output pixel offset for column
+		static inline int index(int col, int width, bool mirror) {
+			return (mirror ? width - 1 - col : col) * 3;
+		}
+
+		static inline uint8_t clamp(int value) {
+			return (uint8_t)std::min(std::max(value, 0), 255);
+		}
+};
@@ -25,6 +25,21 @@
 #define SAVE_COLOR  220,0,0
 #define SAVE_RADIUS 5
 
+// model loading indicator
+#define LOAD_COLOR  255,255,255
+#define LOAD_RADIUS 5
+
+// foveated region of interest
+#define FOVEA_COLOR  0,220,0
+#define FOVEA_SMOOTH 0.2 ///< motion tracking smoothing, 0-1
+
+// style grid
+#define GRID_CELL   128 ///< preferred cell size
+#define GRID_SCROLL 40  ///< scroll amount per mouse wheel step
+
+// style library index & decoded style data, relative to bin/data
+#define STYLE_MANIFEST "style-manifest.bin"
+
 //--------------------------------------------------------------
 ofApp::ofApp() : scaler(1, 1) {}
 
@@ -35,14 +50,25 @@ void ofApp::setup() {
 	ofSetWindowTitle("Styler");
 	ofBackground(0);
 
-	// find style image paths
-	stylePaths = listImagePaths("style");
+	// find style image paths, from the manifest of the last run if available
+	// so large libraries are not listed & decoded at startup
+	if(styleCache.openManifest(STYLE_MANIFEST)) {
+		stylePaths = styleCache.getManifestPaths();
+	}
+	else {
+		stylePaths = listImagePaths("style");
+	}
 	if(stylePaths.empty()) {
 		ofLogError(PACKAGE) << "no style images found in bin/data/style";
 		ofSystemAlertDialog("No style images found in bin/data/style");
 		std::exit(EXIT_FAILURE);
 	}
 
+	// decode new styles & rescan the library in the background
+	styleCache.setup(stylePaths, [this] {return listImagePaths("style");});
+	styleAtlas.setup(styleCache, stylePaths.size());
+	styleGrid.setup(styleAtlas);
+
 	// find input image paths
 	imagePaths = listImagePaths("image");
 	if(imagePaths.empty()) {
@@ -56,10 +82,30 @@ void ofApp::setup() {
 	}
 
 	// input source
-	setCameraSource();
+	if(input != "") {
+		setInputSource();
+	}
+	else if(watch.dir != "") {
+		setWatchSource();
+	}
+	else if(packStart) {
+		setPackSource();
+	}
+	if(!source.current) {
+		setCameraSource();
+	}
 	source.image.player.setFrameTime(3000);
-	size.width = source.current->getWidth();
-	size.height = source.current->getHeight();
+	source.image.player.setCacheSize((std::size_t)imageCacheSize * 1024 * 1024);
+	source.image.player.setPrefetch(imagePrefetch);
+	if(source.current->getWidth() > 0) { // streams: size unknown until first frame
+		size.width = source.current->getWidth();
+		size.height = source.current->getHeight();
+	}
+	if(staticSize) {
+		// decode images at model input size
+		source.image.player.setSize(size.width, size.height);
+		source.watch.folder.setSize(size.width, size.height);
+	}
 
 	// style camera source
 	if(styleCameraSettings.device >= 0) {
@@ -68,6 +114,7 @@ void ofApp::setup() {
 			styleSource.current = styleSource.camera;
 			ofLogVerbose(PACKAGE) << "style camera source: "
 				<< styleCameraSettings.device;
+			setStyleLive(styleLive.enabled);
 		}
 		else {
 			delete styleSource.camera;
@@ -79,12 +126,28 @@ void ofApp::setup() {
 	// output image
 	scaler.setSize(size.width, size.height);
 	ofSetWindowShape(size.width, size.height);
+	styleGrid.setSize(size.width, size.height, GRID_CELL);
 
-	// load model
-	if(!styleTransfer.setup(size.width, size.height)) {
-		std::exit(EXIT_FAILURE);
+	// load model in the background, prefer the pre-optimized model if
+	// available, source is drawn directly until the first output is ready
+	std::string modelPath = "model";
+	if(ofDirectory::doesDirectoryExist("model-optimized")) {
+		modelPath = "model-optimized";
+	}
+	ofLogVerbose(PACKAGE) << "model: " << modelPath;
+	styleTransfer.setupAsync(size.width, size.height, modelPath);
+	setStyle(styleIndex);
+	styleScheduler.setup(styleCache, stylePaths.size(), styleIndex,
+		styleShuffle ? StyleScheduler::ORDER_SHUFFLE : StyleScheduler::ORDER_SEQUENTIAL);
+	styleTransfer.setTiles(tiles.cols, tiles.rows, tiles.perFrame);
+	styleTransfer.setTileOrder(tiles.motion ? ofxStyleTransfer::TILE_ORDER_MOTION
+	                                        : ofxStyleTransfer::TILE_ORDER_ROUND_ROBIN);
+	if(tiles.enabled) {
+		setTiled(true);
+	}
+	else {
+		setFoveated(fovea.enabled);
 	}
-	setStyle(stylePaths[styleIndex]);
 	styleTransfer.startThread();
 
 	// start receiver, if any
@@ -101,9 +164,18 @@ void ofApp::setup() {
 	ofLogVerbose(PACKAGE) << "static size: " << (staticSize ? "true" : "false");
 	ofLogVerbose(PACKAGE) << "style auto: " << (styleAuto ? "true" : "false");
 	ofLogVerbose(PACKAGE) << "style auto time (camera): " << styleAutoTime;
+	ofLogVerbose(PACKAGE) << "style shuffle: " << (styleShuffle ? "true" : "false");
 	ofLogVerbose(PACKAGE) << "style save: " << (styleSave ? "true" : "false");
+	ofLogVerbose(PACKAGE) << "style live: " << (styleLive.enabled ? "true" : "false");
+	ofLogVerbose(PACKAGE) << "style live rate: " << styleLive.rate;
+	ofLogVerbose(PACKAGE) << "foveated: " << (fovea.enabled ? "true" : "false");
+	ofLogVerbose(PACKAGE) << "foveated track: " << (fovea.track ? "true" : "false");
+	ofLogVerbose(PACKAGE) << "tiled: " << (tiles.enabled ? "true" : "false");
+	ofLogVerbose(PACKAGE) << "tiles: " << tiles.cols << "x" << tiles.rows
+		<< ", " << tiles.perFrame << " per frame" << (tiles.motion ? ", motion order" : "");
 	ofLogVerbose(PACKAGE) << stylePaths.size() << " styles:";
 	for(auto p : stylePaths) {ofLogVerbose(PACKAGE) << "" << p;}
+	ofLogVerbose(PACKAGE) << "image cache: " << imageCacheSize << " MB, prefetch " << imagePrefetch;
 	ofLogVerbose(PACKAGE) << imagePaths.size() << " images:";
 	for(auto p : imagePaths) {ofLogVerbose(PACKAGE) << "" << p;}
 	ofLogVerbose(PACKAGE) << videoPaths.size() << " videos:";
@@ -126,6 +198,49 @@ void ofApp::update() {
 		}
 	}
 
+	// style library changed on disk?
+	if(styleCache.update()) {
+		std::string current = stylePaths[styleIndex];
+		stylePaths = styleCache.getPaths();
+		auto found = std::find(stylePaths.begin(), stylePaths.end(), current);
+		styleAtlas.setup(styleCache, stylePaths.size()); // no cells until rebuilt
+		if(found != stylePaths.end()) {
+			styleIndex = found - stylePaths.begin();
+			if(styleAtlasIndex >= 0) { // pip thumbnail until rebuilt
+				styleImage.setFromPixels(stylePixels);
+				styleAtlasIndex = styleIndex;
+			}
+		}
+		else {
+			styleIndex = 0;
+			setStyle(styleIndex);
+		}
+		styleScheduler.setup(styleCache, stylePaths.size(), styleIndex,
+			styleShuffle ? StyleScheduler::ORDER_SHUFFLE : StyleScheduler::ORDER_SEQUENTIAL);
+		ofLogVerbose(PACKAGE) << "styles now " << stylePaths.size();
+	}
+
+	// dropped or osc style loaded?
+	StyleLoader::Loaded loaded;
+	if(styleLoader.receive(loaded)) {
+		styleTransfer.setStyle(loaded.tensor);
+		updateStylePip(*loaded.style);
+		if(source.current->isPaused()) {
+			updateFrame = true;
+		}
+	}
+
+	// style thumbnails ready?
+	if(styleAtlas.update()) {
+		styleGrid.setDirty();
+	}
+
+	// model failed to load in the background?
+	if(styleTransfer.loadFailed()) {
+		ofLogError(PACKAGE) << "could not load model";
+		std::exit(EXIT_FAILURE);
+	}
+
 	// update source frame?
 	source.current->update();
 	if(source.current->isFrameNew() || updateFrame) {
@@ -147,28 +262,107 @@ void ofApp::update() {
 		if(styleAuto && !updateFrame) {
 			if(source.current == &source.camera) {
 				if(ofGetElapsedTimef() - styleAutoTimestamp > styleAutoTime) {
-					nextStyle(); // camera: change on timer
+					autoStyle(); // camera: change on timer
 					styleAutoTimestamp = ofGetElapsedTimef();
 				}
 			}
 			else if(wasLastFrame && !source.current->isPaused()) {
-				nextStyle(); // image(s) & video: change after last frame
+				autoStyle(); // image(s) & video: change after last frame
 			}
 		}
 
-		// input frame
-		styleTransfer.setInput(source.current->getPixels());
+		// follow motion with region of interest?
+		if(fovea.enabled && fovea.track) {
+			trackFoveaRegion(source.current->getPixels());
+		}
+
+		// process tiles with motion first?
+		if(tiles.enabled && tiles.motion) {
+			motion.update(source.current->getPixels());
+			for(int i = 0; i < styleTransfer.getNumTiles(); ++i) {
+				styleTransfer.addTileMotion(i, motion.getMotion(styleTransfer.getTileRect(i)));
+			}
+		}
+
+		// input frame, directly as model input if the source converts
+		const ofFloatPixels *floatPixels = source.current->getFloatPixels();
+		if(floatPixels) {
+			styleTransfer.setInput(*floatPixels);
+		}
+		else {
+			styleTransfer.setInput(source.current->getPixels());
+		}
+		if(source.current == &source.watch) {
+			source.watch.inputId = styleTransfer.getInputId(); // match result
+		}
 		updateFrame = false;
 		wasLastFrame = source.current->isLastFrame();
 	}
+
+	// additional cameras, batched with the camera frame
+	if(source.current == &source.camera && !source.cameraStreams.empty()) {
+		source.cameraStreams.update();
+		for(std::size_t i = 0; i < source.cameraStreams.size(); ++i) {
+			if(source.cameraStreams[i].isFrameNew()) {
+				styleTransfer.setInput(i + 1, source.cameraStreams[i].getPixels());
+			}
+		}
+	}
 	if(styleTransfer.update()) {
 		if(scaler.width != styleTransfer.getOutput().getWidth() ||
 		   scaler.height != styleTransfer.getOutput().getHeight()) {
 			updateScalerModel(); // output size changed
 		}
+		if(source.current == &source.watch) {
+			source.watch.output(styleTransfer.getOutputId(), styleTransfer.getOutput().getPixels());
+		}
+	}
+	if(lockstep && source.current == &source.video && styleTransfer.readyForInput()) {
+		source.video.step(); // next frame once the model took the last
 	}
 	if(styleSource.camera) {
-		styleSource.camera->update();
+
+		// only grab style camera frames which are used, close the device
+		// when unused for a while so it stops capturing & decoding
+		styleCameraDemand.updated = (stylePip || styleCameraDemand.take || liveStyle.isEnabled());
+		float now = ofGetElapsedTimef();
+		if(styleCameraDemand.updated) {
+			styleCameraDemand.timestamp = now;
+			if(styleSource.camera->isSuspended() && now >= styleCameraDemand.retry) {
+				if(styleSource.camera->resume()) {
+					ofLogVerbose(PACKAGE) << "style camera resumed";
+				}
+				else { // blocks while opening, so back off
+					ofLogWarning(PACKAGE) << "could not resume style camera, retrying in "
+						<< styleCameraDemand.idle << " s";
+					styleCameraDemand.retry = now + styleCameraDemand.idle;
+				}
+			}
+			styleSource.camera->update();
+		}
+		else if(!styleSource.camera->isSuspended() &&
+		        now - styleCameraDemand.timestamp > styleCameraDemand.idle) {
+			ofLogVerbose(PACKAGE) << "style camera suspended";
+			styleSource.camera->suspend();
+		}
+		if(styleCameraDemand.take && styleSource.camera->isFrameNew()) {
+			styleCameraDemand.take = false;
+			takeStyle();
+		}
+
+		// live style, prepared in the background at its own rate
+		if(liveStyle.isEnabled()) {
+			if(styleSource.camera->isFrameNew()) {
+				liveStyle.update(styleSource.camera->getPixels());
+			}
+			std::shared_ptr<Style> style;
+			if(liveStyle.receive(style)) {
+				applyStyle(*style);
+				if(source.current->isPaused()) {
+					updateFrame = true;
+				}
+			}
+		}
 	}
 }
 
@@ -188,11 +382,42 @@ void ofApp::draw() {
 		if(styleSource.current && styleSource.current != styleSource.camera) {
 			styleSource.current->draw(0, 0, scaler.width, scaler.height);
 		}
+		else if(!styleTransfer.hasOutput()) {
+			// model still loading, pass through source
+			source.current->draw(0, 0, scaler.width, scaler.height);
+		}
+		else if(source.current == &source.camera && !source.cameraStreams.empty()) {
+			// camera stream outputs in a grid
+			std::size_t count = styleTransfer.getNumStreams();
+			int cols = ceil(sqrt(count)), rows = ceil((float)count / cols);
+			float w = scaler.width / cols, h = scaler.height / rows;
+			for(std::size_t i = 0; i < count; ++i) {
+				ofImage & output = styleTransfer.getOutput(i);
+				if(output.isAllocated()) {
+					output.draw((i % cols) * w, (i / cols) * h, w, h);
+				}
+			}
+		}
 		else {
 			styleTransfer.draw(0, 0);
+			if(debug && fovea.enabled) {
+				const ofRectangle & r = styleTransfer.getRegion();
+				ofPushStyle();
+				ofNoFill();
+				ofSetColor(FOVEA_COLOR);
+				ofDrawRectangle(r.x * scaler.width, r.y * scaler.height,
+				                r.width * scaler.width, r.height * scaler.height);
+				ofPopStyle();
+			}
 		}
 	ofPopMatrix();
 
+	// model loading status
+	if(!styleTransfer.hasOutput()) {
+		ofSetColor(LOAD_COLOR, 127 + 127 * sin(ofGetElapsedTimef() * 4));
+		ofDrawCircle(LOAD_RADIUS + PIP_BORDER + 1, LOAD_RADIUS + PIP_BORDER + 1, LOAD_RADIUS);
+	}
+
 	// style input images
 	if(stylePip) {
 		if(styleSource.camera) {
@@ -207,8 +432,19 @@ void ofApp::draw() {
 		ofDrawRectRounded(styleImageRect.x - PIP_BORDER, styleImageRect.y - PIP_BORDER,
 			styleImageRect.width + PIP_BORDER2, styleImageRect.height + PIP_BORDER2, PIP_BORDER_RADIUS);
 		ofSetColor(255);
-		styleImage.draw(styleImageRect.x, styleImageRect.y,
-			styleImageRect.width, styleImageRect.height);
+		if(styleAtlas.hasCell(styleAtlasIndex)) {
+			styleAtlas.drawCell(styleAtlasIndex, styleImageRect.x, styleImageRect.y,
+				styleImageRect.width, styleImageRect.height);
+		}
+		else {
+			styleImage.draw(styleImageRect.x, styleImageRect.y,
+				styleImageRect.width, styleImageRect.height);
+		}
+	}
+
+	// style browser
+	if(styleGridView) {
+		styleGrid.draw(styleIndex);
 	}
 
 	// style save status
@@ -227,11 +463,30 @@ void ofApp::draw() {
 			text = "source: video\n";
 		}
 		else if(source.current == &source.camera) {
-			text = "source: camera\n";
+			text = (source.cameraStreams.empty() ? "source: camera\n" :
+			        "source: " + ofToString(source.cameraStreams.size() + 1) + " cameras\n");
+		}
+		else if(source.current == &source.pack) {
+			text = "source: frame pack\n";
+		}
+		else if(source.current == &source.pipe) {
+			text = "source: pipe\n";
+		}
+		else if(source.current == &source.shm) {
+			text = "source: shared memory\n";
+		}
+		else if(source.current == &source.v4l2) {
+			text = (source.v4l2.capture.isCompressed() ? "source: v4l2 mjpeg camera\n" : "source: v4l2 camera\n");
+		}
+		else if(source.current == &source.watch) {
+			text = "source: hot folder, " + ofToString(source.watch.folder.getWaiting()) + " waiting\n";
 		}
 		text += "v: video input\n"
 		        "c: camera input\n"
 		        "i: image input\n"
+		        "b: frame pack input\n"
+		        "x: --input stream input\n"
+		        "w: --watch hot folder input\n"
 		        "m: mirror camera";
 		if(styleSource.camera) {
 		text += " / (shift) style camera";
@@ -248,7 +503,13 @@ void ofApp::draw() {
 		if(!styleSource.camera) {
 		text += "k: toggle style input mode\n";
 		}
+		if(styleSource.camera) {
+		text += "l: toggle live style camera\n";
+		}
 		text += "p: toggle style input pip\n"
+		        "o: toggle foveated processing\n"
+		        "t: toggle tiled processing\n"
+		        "g: toggle style grid\n"
 		        "a: toggle auto style change\n"
 		        "right: next style\n"
 		        "left: prev style\n"
@@ -268,6 +529,11 @@ void ofApp::draw() {
 //--------------------------------------------------------------
 void ofApp::exit() {
 	styleTransfer.stopThread();
+	liveStyle.stop();
+	styleScheduler.clear();
+	styleLoader.clear();
+	styleAtlas.clear();
+	styleCache.clear();
 }
 
 //--------------------------------------------------------------
@@ -288,7 +554,7 @@ void ofApp::keyPressed(int key) {
 		case OF_KEY_UP:
 			if(ofGetKeyPressed(OF_KEY_SHIFT)) {
 				if(source.current == &source.video) {
-					source.video.player.nextVideo();
+					source.video.nextVideo();
 				}
 			}
 			else {
@@ -300,7 +566,7 @@ void ofApp::keyPressed(int key) {
 		case OF_KEY_DOWN:
 			if(ofGetKeyPressed(OF_KEY_SHIFT)) {
 				if(source.current == &source.video) {
-					source.video.player.previousVideo();
+					source.video.previousVideo();
 				}
 			}
 			else {
@@ -312,8 +578,13 @@ void ofApp::keyPressed(int key) {
 		case 'v': setVideoSource(); break;
 		case 'c': setCameraSource(); break;
 		case 'i': setImageSource(); break;
+		case 'b': setPackSource(); break;
+		case 'x': setInputSource(); break;
+		case 'w': setWatchSource(); break;
 		case 'm':
 			source.camera.mirror.horz = !source.camera.mirror.horz;
+			source.v4l2.mirror.horz = source.camera.mirror.horz;
+			source.cameraStreams.setMirror(source.camera.mirror.horz, source.camera.mirror.vert);
 			break;
 		case 'M':
 			if(styleSource.camera) {
@@ -322,6 +593,8 @@ void ofApp::keyPressed(int key) {
 			break;
 		case 'n':
 			source.camera.mirror.vert = !source.camera.mirror.vert;
+			source.v4l2.mirror.vert = source.camera.mirror.vert;
+			source.cameraStreams.setMirror(source.camera.mirror.horz, source.camera.mirror.vert);
 			break;
 		case 'N':
 			if(styleSource.camera) {
@@ -356,6 +629,23 @@ void ofApp::keyPressed(int key) {
 		case 'p':
 			stylePip = !stylePip;
 			break;
+		case 'o':
+			setFoveated(!fovea.enabled);
+			break;
+		case 't':
+			setTiled(!tiles.enabled);
+			break;
+		case 'l':
+			if(styleSource.camera) {
+				setStyleLive(!styleLive.enabled);
+			}
+			break;
+		case 'g':
+			styleGridView = !styleGridView;
+			if(styleGridView) {
+				styleGrid.scrollTo(styleIndex);
+			}
+			break;
 		case 'a':
 			styleAuto = !styleAuto;
 			if(styleAuto) {
@@ -396,7 +686,16 @@ void ofApp::mouseDragged(int x, int y, int button) {
 
 //--------------------------------------------------------------
 void ofApp::mousePressed(int x, int y, int button) {
-
+	if(styleGridView) {
+		int index = styleGrid.getIndex(x, y);
+		if(index >= 0) {
+			styleIndex = index;
+			setStyle(styleIndex);
+			if(source.current->isPaused()) {
+				updateFrame = true;
+			}
+		}
+	}
 }
 
 //--------------------------------------------------------------
@@ -404,6 +703,13 @@ void ofApp::mouseReleased(int x, int y, int button) {
 
 }
 
+//--------------------------------------------------------------
+void ofApp::mouseScrolled(int x, int y, float scrollX, float scrollY) {
+	if(styleGridView) {
+		styleGrid.scroll(-scrollY * GRID_SCROLL);
+	}
+}
+
 //--------------------------------------------------------------
 void ofApp::mouseEntered(int x, int y) {
 
@@ -417,6 +723,7 @@ void ofApp::mouseExited(int x, int y) {
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h) {
 	scaler.update(w, h);
+	styleGrid.setSize(w, h, GRID_CELL);
 	updateStyleInputRects();
 }
 
@@ -424,9 +731,6 @@ void ofApp::windowResized(int w, int h) {
 void ofApp::dragEvent(ofDragInfo dragInfo) {
 	if(dragInfo.files.size() == 0) {return;}
 	setStyle(dragInfo.files[0]);
-	if(source.current->isPaused()) {
-		updateFrame = true;
-	}
 }
 
 //--------------------------------------------------------------
@@ -442,6 +746,31 @@ void ofApp::oscReceived(const ofxOscMessage &message) {
 	else if(message.getAddress() == "/style/save") {
 		saveStyleImage();
 	}
+	else if(message.getAddress() == "/style/load") {
+		if(message.getNumArgs() == 1 && message.getTypeString() == "s") {
+			setStyle(message.getArgAsString(0));
+		}
+	}
+	else if(message.getAddress() == "/roi") {
+		if(message.getNumArgs() == 4) {
+			fovea.track = false;
+			styleTransfer.setRegion(message.getArgAsFloat(0), message.getArgAsFloat(1),
+			                        message.getArgAsFloat(2), message.getArgAsFloat(3));
+			if(!fovea.enabled) {
+				setFoveated(true);
+			}
+		}
+	}
+	else if(message.getAddress() == "/roi/track") {
+		fovea.track = (message.getNumArgs() == 0 || message.getArgAsInt(0) > 0);
+		if(fovea.track) {
+			motion.clear();
+			if(!fovea.enabled) {
+				setFoveated(true);
+			}
+		}
+		ofLogVerbose(PACKAGE) << "foveated track: " << (int)fovea.track;
+	}
 	else if(message.getAddress() == "/output/save") {
 		if(message.getNumArgs() == 0) {
                         saveOutputImage();
@@ -462,7 +791,7 @@ void ofApp::prevStyle() {
 	else {
 		styleIndex--;
 	}
-	setStyle(stylePaths[styleIndex]);
+	setStyle(styleIndex);
 }
 
 //--------------------------------------------------------------
@@ -471,31 +800,81 @@ void ofApp::nextStyle() {
 	if(styleIndex >= stylePaths.size()) {
 		styleIndex = 0;
 	}
-	setStyle(stylePaths[styleIndex]);
+	setStyle(styleIndex);
 }
 
 //--------------------------------------------------------------
-void ofApp::setStyle(std::string & path) {
-	ofImage style;
-	if(!style.load(path)) {
+void ofApp::autoStyle() {
+	auto next = styleScheduler.next();
+	if(!next) {
+		nextStyle();
 		return;
 	}
-	if(style.getImageType() != OF_IMAGE_COLOR) {
-		// model requires RGB without alpha, this is expensive
-		style.setImageType(OF_IMAGE_COLOR);
+	styleIndex = next->index;
+	if(next->style) {
+		// prepared, swap in
+		styleTransfer.setStyle(next->tensor);
+		updateStylePip(*next->style, styleIndex);
+		styleGrid.scrollTo(styleIndex);
+	}
+	else {
+		setStyle(styleIndex); // not ready in time
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::setStyle(const std::string & path) {
+	styleLoader.load(path);
+}
+
+//--------------------------------------------------------------
+void ofApp::setStyle(std::size_t index) {
+	auto style = styleCache.load(index); // decodes now if not cached yet
+	if(!style) {
+		return;
+	}
+	applyStyle(*style, index);
+	styleGrid.scrollTo(index);
+	styleScheduler.setCurrent(index);
+
+	// decode neighbors next for browsing
+	styleCache.prioritize((index + 1) % stylePaths.size());
+	styleCache.prioritize((index + stylePaths.size() - 1) % stylePaths.size());
+}
+
+//--------------------------------------------------------------
+void ofApp::applyStyle(const Style & style, int index) {
+	styleTransfer.setStyle(style.pixels);
+	updateStylePip(style, index);
+}
+
+//--------------------------------------------------------------
+void ofApp::updateStylePip(const Style & style, int index) {
+	if(style.path != "") {
+		ofLogVerbose(PACKAGE) << "style now " << ofFilePath::getFileName(style.path);
+	}
+	stylePixels = style.thumbnail;
+	stylePath = style.path;
+	styleAtlasIndex = index;
+	if(!styleAtlas.hasCell(styleAtlasIndex)) {
+		// not in atlas (yet), upload thumbnail
+		styleImage.setFromPixels(style.thumbnail);
 	}
-	ofLogVerbose(PACKAGE) << "style now " << ofFilePath::getFileName(path);
-	styleTransfer.setStyle(style.getPixels());
-	styleImage.setFromPixels(style.getPixels());
 	updateStyleInputRects();
 }
 
 //--------------------------------------------------------------
 void ofApp::takeStyle() {
+	if(styleSource.camera && styleSource.current == styleSource.camera &&
+	   !styleCameraDemand.updated) {
+		styleCameraDemand.take = true; // camera idle, take from the next frame
+		return;
+	}
 	if(styleSource.current) {
-		styleTransfer.setStyle(styleSource.current->getPixels());
-		styleImage.setFromPixels(styleSource.current->getPixels());
-		updateStyleInputRects();
+		// only the small model & thumbnail pixels are uploaded
+		ofPixels pixels = styleSource.current->getPixels();
+		applyStyle(*StyleCache::fromPixels(pixels));
+		stylePixels = styleSource.current->getPixels();
 	}
 	if(!styleSource.camera) { // done
 		styleSource.current = nullptr;
@@ -509,8 +888,19 @@ void ofApp::takeStyle() {
 //--------------------------------------------------------------
 void ofApp::saveStyleImage() {
 	ofDirectory::createDirectory("output-style");
-	std::string path = "output-style/"+ofGetTimestampString("%m-%d-%Y_%H-%M-%S")+".png";
-	ofSaveImage(styleImage.getPixels(), path);
+	std::string path = "output-style/"+ofGetTimestampString("%m-%d-%Y_%H-%M-%S");
+	if(stylePath != "") {
+		// only a thumbnail is kept for files, copy the full size original
+		path += "." + ofToLower(ofFilePath::getFileExt(stylePath));
+		if(!ofFile::copyFromTo(stylePath, path, true, true)) {
+			ofLogWarning(PACKAGE) << "could not save style " << path;
+			return;
+		}
+	}
+	else {
+		path += ".png";
+		ofSaveImage(stylePixels, path);
+	}
 	ofLogVerbose(PACKAGE) << "saved style " << path;
 }
 
@@ -522,14 +912,90 @@ void ofApp::saveOutputImage() {
 	ofLogVerbose(PACKAGE) << "saved " << path;
 }
 
+//--------------------------------------------------------------
+void ofApp::setStyleLive(bool live) {
+	styleLive.enabled = live;
+	if(styleLive.enabled) {
+		liveStyle.setRate(styleLive.rate);
+		liveStyle.start();
+	}
+	else {
+		liveStyle.stop();
+	}
+	ofLogVerbose(PACKAGE) << "style live: " << (int)styleLive.enabled;
+}
+
+//--------------------------------------------------------------
+void ofApp::setFoveated(bool foveated) {
+	if(source.current == &source.watch) {
+		foveated = false; // hot folder results are full frame passes
+	}
+	else if(foveated && styleTransfer.getNumStreams() > 1) {
+		ofLogWarning(PACKAGE) << "foveated processing is not supported with multiple cameras";
+		foveated = false; // extra streams are only processed in full passes
+	}
+	fovea.enabled = foveated;
+	if(fovea.enabled) {
+		tiles.enabled = false;
+	}
+	styleTransfer.setMode(fovea.enabled ? ofxStyleTransfer::MODE_FOVEATED
+	                                    : ofxStyleTransfer::MODE_FULL);
+	ofLogVerbose(PACKAGE) << "foveated: " << (int)fovea.enabled;
+}
+
+//--------------------------------------------------------------
+void ofApp::setTiled(bool tiled) {
+	if(source.current == &source.watch) {
+		tiled = false; // hot folder results are full frame passes
+	}
+	else if(tiled && styleTransfer.getNumStreams() > 1) {
+		ofLogWarning(PACKAGE) << "tiled processing is not supported with multiple cameras";
+		tiled = false; // extra streams are only processed in full passes
+	}
+	tiles.enabled = tiled;
+	if(tiles.enabled) {
+		fovea.enabled = false;
+		motion.clear();
+	}
+	styleTransfer.setMode(tiles.enabled ? ofxStyleTransfer::MODE_TILED
+	                                    : ofxStyleTransfer::MODE_FULL);
+	ofLogVerbose(PACKAGE) << "tiled: " << (int)tiles.enabled;
+}
+
+//--------------------------------------------------------------
+void ofApp::trackFoveaRegion(const ofPixels & pixels) {
+	motion.update(pixels);
+	if(!motion.hasMotion()) {return;}
+	const ofRectangle & region = styleTransfer.getRegion();
+	const glm::vec2 & centroid = motion.getCentroid();
+	float x = ofLerp(region.x + region.width * 0.5, centroid.x, FOVEA_SMOOTH);
+	float y = ofLerp(region.y + region.height * 0.5, centroid.y, FOVEA_SMOOTH);
+	x = ofClamp(x - region.width * 0.5, 0, 1 - region.width);
+	y = ofClamp(y - region.height * 0.5, 0, 1 - region.height);
+	styleTransfer.setRegion(x, y, region.width, region.height);
+}
+
 //--------------------------------------------------------------
 void ofApp::setVideoSource() {
+	source.video.threaded = videoThread;
+	if(staticSize) {
+		source.video.setDecodeSize(size.width, size.height); // decode at model input size
+	}
 	if(!source.video.open(videoPaths)) {return;}
+	source.video.setLockstep(lockstep);
 	source.video.play();
 	source.video.setVolume(0);
 	source.current = &source.video;
+	styleTransfer.setRefine(false);
 	source.camera.close();
+	source.cameraStreams.close();
+	styleTransfer.setStreams(1);
 	source.image.close();
+	source.pack.close();
+	source.pipe.close();
+	source.shm.close();
+	source.v4l2.close();
+	source.watch.close();
 	wasLastFrame = false;
 	styleAutoTimestamp = ofGetElapsedTimef();
 	ofLogVerbose(PACKAGE) << "video source";
@@ -538,9 +1004,21 @@ void ofApp::setVideoSource() {
 //--------------------------------------------------------------
 void ofApp::setCameraSource() {
 	source.camera.setup(cameraSettings);
+	source.cameraStreams.setup(cameraDevices, cameraSettings);
+	styleTransfer.setStreams(1 + source.cameraStreams.size()); // other sources only use stream 0
 	source.current = &source.camera;
+	styleTransfer.setRefine(false);
+	if(styleTransfer.getNumStreams() > 1) {
+		setFoveated(false); // extra streams are only processed in full passes
+		setTiled(false);
+	}
 	source.video.close();
 	source.image.close();
+	source.pack.close();
+	source.pipe.close();
+	source.shm.close();
+	source.v4l2.close();
+	source.watch.close();
 	wasLastFrame = false;
 	styleAutoTimestamp = ofGetElapsedTimef();
 	ofLogVerbose(PACKAGE) << "camera source";
@@ -551,13 +1029,106 @@ void ofApp::setImageSource() {
 	if(!source.image.open(imagePaths)) {return;}
 	source.image.play();
 	source.current = &source.image;
+	styleTransfer.setRefine(true); // quick preview for stills
 	source.video.close();
 	source.camera.close();
+	source.cameraStreams.close();
+	styleTransfer.setStreams(1);
+	source.pack.close();
+	source.pipe.close();
+	source.shm.close();
+	source.v4l2.close();
+	source.watch.close();
 	wasLastFrame = false;
 	styleAutoTimestamp = ofGetElapsedTimef();
 	ofLogVerbose(PACKAGE) << "image source";
 }
 
+//--------------------------------------------------------------
+void ofApp::setPackSource() {
+	if(!source.pack.open(packPath)) {return;}
+	source.pack.play();
+	source.current = &source.pack;
+	styleTransfer.setRefine(false);
+	source.video.close();
+	source.camera.close();
+	source.cameraStreams.close();
+	styleTransfer.setStreams(1);
+	source.image.close();
+	source.pipe.close();
+	source.shm.close();
+	source.v4l2.close();
+	source.watch.close();
+	wasLastFrame = false;
+	styleAutoTimestamp = ofGetElapsedTimef();
+	ofLogVerbose(PACKAGE) << "frame pack source";
+}
+
+//--------------------------------------------------------------
+void ofApp::setInputSource() {
+	if(input == "") {return;}
+	if(input == "-" || input.compare(0, 5, "pipe:") == 0) {
+		std::string path = (input == "-" ? input : input.substr(5));
+		if(!source.pipe.open(path, cameraSettings.size.width, cameraSettings.size.height)) {return;}
+		source.current = &source.pipe;
+		source.shm.close();
+		source.v4l2.close();
+	}
+	else if(input.compare(0, 4, "shm:") == 0) {
+		if(!source.shm.open(input.substr(4))) {return;}
+		source.current = &source.shm;
+		source.pipe.close();
+		source.v4l2.close();
+	}
+	else if(input.compare(0, 5, "v4l2:") == 0 || input.compare(0, 6, "mjpeg:") == 0) {
+		bool mjpeg = (input[0] == 'm');
+		if(staticSize) {
+			source.v4l2.setDecodeSize(size.width, size.height); // decode at model input size
+		}
+		if(!source.v4l2.open(input.substr(mjpeg ? 6 : 5), cameraSettings, mjpeg)) {return;}
+		source.current = &source.v4l2;
+		source.pipe.close();
+		source.shm.close();
+	}
+	else {
+		ofLogWarning(PACKAGE) << "unknown input: " << input;
+		return;
+	}
+	styleTransfer.setRefine(false);
+	source.video.close();
+	source.camera.close();
+	source.cameraStreams.close();
+	styleTransfer.setStreams(1);
+	source.image.close();
+	source.pack.close();
+	source.watch.close();
+	wasLastFrame = false;
+	styleAutoTimestamp = ofGetElapsedTimef();
+	ofLogVerbose(PACKAGE) << "input source: " << input;
+}
+
+//--------------------------------------------------------------
+void ofApp::setWatchSource() {
+	if(watch.dir == "") {return;}
+	if(!source.watch.open(watch.dir, watch.output, watch.threads)) {return;}
+	source.current = &source.watch;
+	styleTransfer.setRefine(false);
+	setFoveated(false); // locked off while current
+	setTiled(false);
+	source.video.close();
+	source.camera.close();
+	source.cameraStreams.close();
+	styleTransfer.setStreams(1);
+	source.image.close();
+	source.pack.close();
+	source.pipe.close();
+	source.shm.close();
+	source.v4l2.close();
+	wasLastFrame = false;
+	styleAutoTimestamp = ofGetElapsedTimef();
+	ofLogVerbose(PACKAGE) << "watch source: " << watch.dir << " -> " << watch.output;
+}
+
 //--------------------------------------------------------------
 void ofApp::updateScalerModel() {
 	scaler.setSize(styleTransfer.getOutput().getWidth(),
@@ -582,7 +1153,13 @@ void ofApp::updateStyleInputRects() {
 		styleCameraRect.set(x, y, w, h);
 		y = h + PIP_BORDER2;
 	}
-	h = (float)styleImage.getHeight() * (w / (float)styleImage.getWidth());
+	if(styleAtlas.hasCell(styleAtlasIndex)) {
+		const ofRectangle & cell = styleAtlas.getCell(styleAtlasIndex);
+		h = cell.height * (w / cell.width);
+	}
+	else {
+		h = (float)styleImage.getHeight() * (w / (float)styleImage.getWidth());
+	}
 	styleImageRect.set(x, y, w, h);
 }
 
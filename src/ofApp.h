@@ -21,6 +21,13 @@
 #include "ofxOsc.h"
 #include "Source.h"
 #include "Scaler.h"
+#include "MotionDetector.h"
+#include "StyleCache.h"
+#include "StyleAtlas.h"
+#include "StyleGrid.h"
+#include "LiveStyle.h"
+#include "StyleScheduler.h"
+#include "StyleLoader.h"
 #include "config.h"
 
 /// advanced arbitrary style transfer which can dynamically change between input
@@ -41,6 +48,7 @@ class ofApp : public ofBaseApp {
 		void mouseDragged(int x, int y, int button);
 		void mousePressed(int x, int y, int button);
 		void mouseReleased(int x, int y, int button);
+		void mouseScrolled(int x, int y, float scrollX, float scrollY);
 		void mouseEntered(int x, int y);
 		void mouseExited(int x, int y);
 		void windowResized(int w, int h);
@@ -56,10 +64,24 @@ class ofApp : public ofBaseApp {
 		/// goto next style in the stylePaths vector
 		void nextStyle();
 
-		/// set style from given input image
-		void setStyle(std::string & path);
+		/// goto next automatic style change style, prepared ahead of time
+		void autoStyle();
 
-		/// take current source frame as style image
+		/// set style from given input image, loaded in the background &
+		/// applied when ready
+		void setStyle(const std::string & path);
+
+		/// set style from the stylePaths vector by index, uses styleCache
+		void setStyle(std::size_t index);
+
+		/// set decoded style, index is the stylePaths index if from the library
+		void applyStyle(const Style & style, int index=-1);
+
+		/// update style pip for decoded style, see applyStyle()
+		void updateStylePip(const Style & style, int index=-1);
+
+		/// take current source frame as style image, an idle style camera
+		/// is updated first & the style is taken from its next frame
 		/// optionally saves style image if styleSave = true
 		void takeStyle();
 
@@ -72,6 +94,15 @@ class ofApp : public ofBaseApp {
 		/// switch to image source
 		void setImageSource();
 
+		/// switch to frame pack source
+		void setPackSource();
+
+		/// switch to stream input source set via --input
+		void setInputSource();
+
+		/// switch to hot folder source set via --watch
+		void setWatchSource();
+
 		/// update scaler for model output image
 		void updateScalerModel();
 
@@ -87,9 +118,22 @@ class ofApp : public ofBaseApp {
 		/// save current output image
 		void saveOutputImage();
 
+		/// enable/disable foveated processing
+		void setFoveated(bool foveated);
+
+		/// enable/disable tiled processing
+		void setTiled(bool tiled);
+
+		/// enable/disable continuous style from the style camera
+		void setStyleLive(bool live);
+
+		/// move foveated region of interest towards the motion centroid
+		void trackFoveaRegion(const ofPixels & pixels);
+
 		// config settings
 		CameraSourceSettings cameraSettings;
 		CameraSourceSettings styleCameraSettings;
+		std::vector<int> cameraDevices; ///< additional cameras batched with the camera
 
 		/// helper to get jpg & png paths in a given directory
 		std::vector<std::string> listImagePaths(std::string dirPath);
@@ -104,6 +148,7 @@ class ofApp : public ofBaseApp {
 		bool updateFrame = false; ///< update current output?
 		bool stylePip = false; ///< draw style input & camera pip?
 		bool styleAuto = false;  ///< change style automatically?
+		bool styleShuffle = false; ///< shuffle automatic style change order?
 		bool wasLastFrame = false; ///< was the prev source frame the last?
 
 		/// timestamp in s for last style change, only used for camera source
@@ -117,21 +162,57 @@ class ofApp : public ofBaseApp {
 			Source *current = nullptr; ///< set this before using!
 			PlayerSource video;
 			CameraSource camera;
+			CameraStreams cameraStreams; ///< additional cameras, see cameraDevices
 			ImageSource image;
+			PackSource pack;
+			PipeSource pipe;
+			ShmSource shm;
+			V4l2Source v4l2;
+			WatchSource watch;
 		} source;
 		std::vector<std::string> imagePaths;
+		int imageCacheSize = 256; ///< decoded image source cache size in MB
+		int imagePrefetch = 2; ///< image source images to decode ahead
 		std::vector<std::string> videoPaths;
+		bool lockstep = false; ///< advance video only when the model is ready?
+		bool videoThread = false; ///< decode video on its own thread?
+		std::string packPath = "frames.pack"; ///< frame pack source path
+		bool packStart = false; ///< start with frame pack source?
+		std::string input = ""; ///< stream input: "-", "pipe:path", "shm:/name", "v4l2:/dev/videoN", or "mjpeg:/dev/videoN"
+
+		// hot folder input
+		struct {
+			std::string dir = ""; ///< watched input folder
+			std::string output = "output-watch"; ///< result folder
+			int threads = 2; ///< decode & encode threads
+		} watch;
 
 		// style source
 		struct {
 			Source *current = nullptr; ///< current style input
 			CameraSource *camera = nullptr; ///< optional second camera input
 		} styleSource;
-		ofImage styleImage; ///< current style input image
+		struct {
+			bool take = false; ///< take style from the next style camera frame?
+			bool updated = false; ///< was the style camera updated this frame?
+			float timestamp = 0; ///< last update timestamp in s
+			float idle = 5; ///< suspend after unused for this long in s
+			float retry = 0; ///< next resume attempt timestamp after a failure
+		} styleCameraDemand; ///< style camera is only updated when used
+		ofImage styleImage; ///< current style thumbnail, if not in styleAtlas
+		ofPixels stylePixels; ///< current style thumbnail or taken style input frame
+		std::string stylePath; ///< current style image file, saved instead of stylePixels
 		ofRectangle styleImageRect; ///< style image draw rect
 		ofRectangle styleCameraRect; ///< style camera draw rect
 		bool styleSave = false; ///< save style images when saving?
 
+		// live style from style camera
+		struct {
+			bool enabled = false; ///< continuously take style camera frames?
+			float rate = 2; ///< style update rate in Hz
+		} styleLive;
+		LiveStyle liveStyle; ///< prepares live styles in the background
+
 		// input / output sizes
 		struct {
 			int width = 1;
@@ -142,6 +223,30 @@ class ofApp : public ofBaseApp {
 
 		std::vector<std::string> stylePaths; ///< paths to available style images
 		std::size_t styleIndex = 0; ///< current style path index
+		StyleCache styleCache; ///< decoded styles for stylePaths
+		StyleAtlas styleAtlas; ///< packed thumbnails for stylePaths
+		StyleGrid styleGrid; ///< style browser view of styleAtlas
+		StyleScheduler styleScheduler; ///< prepares the next auto style
+		StyleLoader styleLoader; ///< loads styles from outside the library
+		bool styleGridView = false; ///< show style grid?
+		int styleAtlasIndex = -1; ///< current style atlas cell, -1 if not in library
+
+		MotionDetector motion; ///< frame differencing for tracking & tiles
+
+		// foveated processing
+		struct {
+			bool enabled = false; ///< full res region of interest, low res elsewhere?
+			bool track = false; ///< follow motion centroid with region of interest?
+		} fovea;
+
+		// tiled processing
+		struct {
+			bool enabled = false; ///< spread processing over tiles?
+			int cols = 2; ///< grid columns
+			int rows = 2; ///< grid rows
+			int perFrame = 1; ///< tiles processed per model pass
+			bool motion = false; ///< process tiles with the most motion first?
+		} tiles;
 
 		// osc
 		struct {
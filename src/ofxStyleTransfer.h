@@ -11,6 +11,9 @@
 #include "ofxTensorFlow2.h"
 #include "ofFileUtils.h"
 
+#include <atomic>
+#include <thread>
+
 /// \class ofxStyleTransfer
 /// \brief wrapper for the arbitrary style transfer model
 ///
@@ -49,6 +52,27 @@
 ///     }
 /// }
 ///
+/// the model can also be loaded in the background with setupAsync() to avoid
+/// blocking on startup, in which case update() does nothing until isLoaded()
+/// returns true
+///
+/// processing modes:
+/// * MODE_FULL: default, the whole input is processed in a single pass
+/// * MODE_FOVEATED: two passes per input, the region of interest set via
+///                  setRegion() at full resolution & the whole input at lower
+///                  resolution, composited with a feathered mask
+/// * MODE_TILED: the input is split into tiles set via setTiles() & one or
+///               more tiles are processed per pass, each finished tile is
+///               written into the output image immediately
+///
+/// for still images, MODE_FULL can also refine progressively via setRefine():
+/// a fast low res preview pass is shown first, followed by the full res pass,
+/// any new input or style drops stale passes & starts with a new preview
+///
+/// for multiple inputs, ie. cameras, MODE_FULL can also process streams set
+/// via setStreams(): the new inputs of all streams are stacked into a single
+/// batched pass with the same style & each stream has its own output image
+///
 class ofxStyleTransfer {
 	public:
 
@@ -56,111 +80,282 @@ class ofxStyleTransfer {
 		static const int STYLE_W = 256; ///< style image width expected by the model
 		static const int STYLE_H = 256; ///< style image height expected by the model
 
+		/// processing mode
+		enum Mode {
+			MODE_FULL,     ///< whole input in one pass
+			MODE_FOVEATED, ///< full res region of interest, low res elsewhere
+			MODE_TILED     ///< tiles spread over multiple passes
+		};
+
+		/// tiled mode processing order
+		enum TileOrder {
+			TILE_ORDER_ROUND_ROBIN, ///< oldest tile first
+			TILE_ORDER_MOTION       ///< tile with the most motion first
+		};
+
+		ofxStyleTransfer() {}
+		virtual ~ofxStyleTransfer() {
+			if(loader.joinable()) {loader.join();}
+		}
+
 		/// load and set up style transfer model with input/output image size
 		/// returns true on success
 		bool setup(int width, int height, const std::string & modelPath="model") {
-
-			// model
-			if(!ofxTF2::setGPUMaxMemory(ofxTF2::GPU_PERCENT_90, true)) {
-				ofLogError("ofxStyleTransfer") << "failed to set GPU Memory options";
+			if(!init(width, height)) {
+				loadState = LOAD_FAILED;
 				return false;
 			}
-			if(!model.load(modelPath)) {
-				return false;
+			loadState = (load(modelPath) ? LOADED : LOAD_FAILED);
+			return loadState == LOADED;
+		}
+
+		/// load and set up style transfer model with input/output image size in
+		/// a background thread, includes a warm up run so the first inference
+		/// is not slowed by lazy initialization
+		///
+		/// input & style can be set while loading, processing starts once
+		/// loaded, check isLoaded() and loadFailed() for status
+		void setupAsync(int width, int height, const std::string & modelPath="model") {
+			if(loader.joinable()) {loader.join();}
+			if(!init(width, height)) {
+				loadState = LOAD_FAILED;
+				return;
 			}
-			std::vector<std::string> inputNames = {
-				"serving_default_placeholder",
-				"serving_default_placeholder_1"
-			};
-			std::vector<std::string> outputNames = {
-				"StatefulPartitionedCall"
-			};
-			model.setup(inputNames, outputNames);
+			loadState = LOADING;
+			int w = size.width, h = size.height; // setSize() may change size meanwhile
+			loader = std::thread([this, modelPath, w, h] {
+				if(!load(modelPath)) {
+					loadState = LOAD_FAILED;
+					return;
+				}
+				warmUp(w, h);
+				loadState = LOADED;
+			});
+		}
 
-			// input
-			inputVector = {cppflow::tensor(0), cppflow::tensor(0)};
-			setSize(width, height);
+		/// returns true if the model is loaded and ready
+		bool isLoaded() const {return loadState == LOADED;}
 
-			// output
-			outputImage.allocate(size.width, size.height, OF_IMAGE_COLOR);
-			return true;
-		}
+		/// returns true if the model failed to load
+		bool loadFailed() const {return loadState == LOAD_FAILED;}
+
+		/// returns true if at least one output image has been processed
+		bool hasOutput() const {return outputFrames > 0;}
+
+		/// returns true if the last input has been taken for processing, so
+		/// the next input would not replace an unprocessed input
+		bool readyForInput() const {return loadState == LOADED && !newInput;}
+
+		/// returns id of the last input set, counting from 1
+		unsigned long getInputId() const {return inputId;}
+
+		/// returns input id of the current full frame output in MODE_FULL
+		/// without refinement, 0 if none, ie. to match outputs to inputs
+		unsigned long getOutputId() const {return outputId;}
 
 		/// clear model
 		void clear() {
+			if(loader.joinable()) {loader.join();}
 			model.clear();
+			loadState = NOT_LOADED;
+			outputFrames = 0;
 		}
 
 		/// set input pixels to process, resizes as needed
 		/// image type must be RGB without alpha
 		/// note: set the style image before calling this!
 		void setInput(const ofPixels & pixels) {
-			cppflow::tensor image = pixelsToFloatTensor(pixels);
-			if(pixels.getHeight() != modelSize.width || pixels.getWidth() != modelSize.height) {
-				image = cppflow::resize_bicubic(image, cppflow::tensor({size.height, size.width}), true);
-			}
-			inputVector[0] = image;
-			newInput = true;
+			setInput(pixelsToFloatTensor(pixels), pixels.getWidth(), pixels.getHeight());
+		}
+
+		/// set input pixels already normalized to 0-1, ie. converted by the
+		/// source directly from the camera format, resizes as needed
+		/// image type must be RGB without alpha
+		/// note: set the style image before calling this!
+		void setInput(const ofFloatPixels & pixels) {
+			cppflow::tensor image = cppflow::expand_dims(ofxTF2::pixelsToTensor(pixels), 0);
+			setInput(image, pixels.getWidth(), pixels.getHeight());
 		}
 
 		/// set input style image, resizes as needed
 		/// image type must be RGB without alpha
 		void setStyle(const ofPixels & pixels) {
+			setStyle(styleToTensor(pixels));
+		}
+
+		/// convert style image to model style input, resizes as needed,
+		/// safe to call from any thread so styles can be prepared ahead
+		/// image type must be RGB without alpha
+		static cppflow::tensor styleToTensor(const ofPixels & pixels) {
 			auto style = pixelsToFloatTensor(pixels);
 			if(pixels.getHeight() != STYLE_W || pixels.getWidth() != STYLE_H) {
 				style = cppflow::resize_bicubic(style, cppflow::tensor({STYLE_H, STYLE_W}), true);
 			}
+			return style;
+		}
+
+		/// set style from model style input prepared with styleToTensor()
+		void setStyle(const cppflow::tensor & style) {
 			inputVector[1] = style;
+			generation++;
+			if(refine.enabled && refine.stage != Refine::IDLE) {
+				refine.stage = Refine::PREVIEW_NEXT; // restart with new style
+			}
 		}
 
 		/// run model on current input, either synchronously by blocking until
 		/// finished or asynchronously if background thread is running
 		/// returns true if output image is new
 		bool update() {
-			if(model.isThreadRunning()) {
-				// non-blocking
-				if(newInput && model.readyForInput()) {
-					model.update(inputVector);
-					newInput = false;
-					inputVector[0] = cppflow::tensor(0); // clear input image
+			if(loadState != LOADED) {return false;}
+			if(loader.joinable()) {
+				// finished loading in the background
+				loader.join();
+				if(startOnLoad) {
+					startThread();
 				}
-				if(model.isOutputNew()) {
+			}
+			bool updated = false;
+			if(model.isThreadRunning()) {
+				// non-blocking, one pass per model run
+				if(pending && model.isOutputNew()) {
 					auto output = model.getOutputs();
-					if(sizeChanged) {
-						// reallocate for new input size
-						outputImage.allocate(size.width, size.height, OF_IMAGE_COLOR);
-						sizeChanged = false;
-					}
-					if(size.width != outputImage.getWidth() ||
-					   size.height != outputImage.getHeight()) {
-						// change size in next output frame
-						sizeChanged = true;
-					}
-					if(modelSize.width != outputImage.getWidth() ||
-					   modelSize.height != outputImage.getHeight()) {
-						resizeTensorToImage(output[0], outputImage);
+					pending = false;
+					updated = passOutput(output[0]);
+				}
+				if(!pending && model.readyForInput()) {
+					std::vector<cppflow::tensor> inputs;
+					if(nextPass(inputs)) {
+						model.update(inputs);
+						pending = true;
 					}
-					floatTensorToImage(output[0], outputImage);
-					outputImage.update();
-					return true;
 				}
 			}
 			else {
-				// blocking
-				if(newInput) {
-					auto output = model.runMultiModel(inputVector);
-					if(modelSize.width != outputImage.getWidth() ||
-					   modelSize.height != outputImage.getHeight()) {
-						resizeTensorToImage(output[0], outputImage);
-					}
-					floatTensorToImage(output[0], outputImage);
-					outputImage.update();
-					newInput = false;
-					inputVector[0] = cppflow::tensor(0); // clear input image
-					return true;
+				// blocking, run all passes for the current input
+				std::vector<cppflow::tensor> inputs;
+				while(nextPass(inputs)) {
+					auto output = model.runMultiModel(inputs);
+					updated = passOutput(output[0]) || updated;
+					if(mode == MODE_TILED) {break;} // spread over updates
 				}
 			}
-			return false;
+			if(updated) {
+				outputFrames++;
+			}
+			return updated;
+		}
+
+		/// set processing mode, takes effect once the current pass is done
+		void setMode(Mode mode) {nextMode = mode;}
+
+		/// returns current processing mode
+		Mode getMode() const {return nextMode;}
+
+		/// set normalized region of interest for the foveated mode,
+		/// region is rounded up to multiples of 32 in input pixels
+		void setRegion(float x, float y, float w, float h) {
+			fovea.region.set(ofClamp(x, 0, 1), ofClamp(y, 0, 1),
+			                 ofClamp(w, 0, 1), ofClamp(h, 0, 1));
+		}
+
+		/// set normalized region of interest for the foveated mode
+		void setRegion(const ofRectangle & region) {
+			setRegion(region.x, region.y, region.width, region.height);
+		}
+
+		/// returns normalized region of interest for the foveated mode
+		const ofRectangle & getRegion() const {return fovea.region;}
+
+		/// set foveated mode low res pass scale, 0-1, default 0.5
+		void setFoveaScale(float scale) {fovea.scale = ofClamp(scale, 0.1, 1);}
+
+		/// set foveated mode mask feather as percent of the region size, 0-0.5,
+		/// default 0.15
+		void setFoveaFeather(float feather) {fovea.feather = ofClamp(feather, 0, 0.5);}
+
+		/// enable/disable progressive refinement for still images in MODE_FULL:
+		/// each new input or style is first processed at low res for a quick
+		/// preview, followed by a full res pass
+		void setRefine(bool refine) {
+			this->refine.enabled = refine;
+			this->refine.stage = Refine::IDLE;
+			this->refine.input = cppflow::tensor(0);
+			generation++; // drop pass being processed, if any
+		}
+
+		/// returns true if progressive refinement is enabled
+		bool getRefine() const {return refine.enabled;}
+
+		/// set refinement preview pass scale, 0-1, default 0.25
+		void setRefineScale(float scale) {refine.scale = ofClamp(scale, 0.1, 1);}
+
+		/// set tiled mode grid & number of tiles processed per pass,
+		/// tiles in the same pass are batched into a single model run
+		void setTiles(int cols, int rows, int perPass=1) {
+			tiles.cols = std::max(cols, 1);
+			tiles.rows = std::max(rows, 1);
+			tiles.perPass = ofClamp(perPass, 1, tiles.cols * tiles.rows);
+			tiles.state.assign(tiles.cols * tiles.rows, Tiles::State());
+			tiles.size = {0, 0}; // recompute rects
+		}
+
+		/// returns number of tiles in the tiled mode grid
+		int getNumTiles() const {return tiles.cols * tiles.rows;}
+
+		/// returns normalized rect of a tile in the tiled mode grid
+		ofRectangle getTileRect(int index) const {
+			float w = 1.f / tiles.cols, h = 1.f / tiles.rows;
+			return ofRectangle((index % tiles.cols) * w, (index / tiles.cols) * h, w, h);
+		}
+
+		/// set tiled mode processing order
+		void setTileOrder(TileOrder order) {tiles.order = order;}
+
+		/// add motion amount to a tile for TILE_ORDER_MOTION, accumulates
+		/// until the tile is processed
+		void addTileMotion(int index, float amount) {
+			if(index >= 0 && (std::size_t)index < tiles.state.size()) {
+				tiles.state[index].motion += amount;
+			}
+		}
+
+		/// set number of input streams processed as one batch in MODE_FULL
+		/// without refinement, stream 0 is the regular input & output,
+		/// 1 for a single input
+		void setStreams(std::size_t count) {
+			count = std::max<std::size_t>(count, 1);
+			streams.inputs.assign(count, cppflow::tensor(0));
+			streams.sizes.assign(count, Size());
+			streams.fresh.assign(count, false);
+			streams.outputs.resize(count); // keeps batch being processed
+		}
+
+		/// returns number of input streams
+		std::size_t getNumStreams() const {return std::max<std::size_t>(streams.inputs.size(), 1);}
+
+		/// set input pixels for a stream, stream 0 is the same as setInput(),
+		/// resizes to the input size as needed
+		/// image type must be RGB without alpha
+		void setInput(std::size_t stream, const ofPixels & pixels) {
+			if(stream == 0) {
+				setInput(pixels);
+				return;
+			}
+			if(stream >= streams.inputs.size()) {return;}
+			auto image = pixelsToFloatTensor(pixels);
+			if((int)pixels.getWidth() != size.width || (int)pixels.getHeight() != size.height) {
+				image = cppflow::resize_bicubic(image, cppflow::tensor({size.height, size.width}), true);
+			}
+			streams.inputs[stream] = image;
+			streams.sizes[stream] = size;
+			streams.fresh[stream] = true;
+		}
+
+		/// get processed output image for a stream, stream 0 is getOutput()
+		ofImage & getOutput(std::size_t stream) {
+			return (stream == 0 || stream >= streams.outputs.size() ?
+			        outputImage : streams.outputs[stream]);
 		}
 
 		/// get processed output image
@@ -181,14 +376,21 @@ class ofxStyleTransfer {
 			outputImage.draw(x, y, w, h);
 		}
 
-		/// start background thread processing
+		/// start background thread processing,
+		/// delayed until loaded if loading in the background
 		void startThread() {
-			sizeChanged = false; // reset change detection
+			if(loadState != LOADED || loader.joinable()) {
+				startOnLoad = true;
+				return;
+			}
+			startOnLoad = false;
+			pending = false;
 			model.startThread();
 		}
 
 		/// stop background thread processing
 		void stopThread() {
+			startOnLoad = false;
 			model.stopThread();
 		}
 
@@ -218,10 +420,6 @@ class ofxStyleTransfer {
 			//		<< " not multiple(s) of 32, rounding up to "
 			//		<< modelSize.width << "x" << modelSize.height;
 			//}
-			if(model.isThreadRunning() && model.readyForInput()) {
-				// resize output image if not processing in background thread
-				sizeChanged = true;
-			}
 		}
 
 		// round n up to nearest multiple, positive only
@@ -232,8 +430,53 @@ class ofxStyleTransfer {
 	protected:
 		ofxTF2::ThreadedModel model;
 
+		// set up input & output before loading, returns false on error
+		bool init(int width, int height) {
+
+			// GPU options must be set before any other TF calls
+			if(!ofxTF2::setGPUMaxMemory(ofxTF2::GPU_PERCENT_90, true)) {
+				ofLogError("ofxStyleTransfer") << "failed to set GPU Memory options";
+				return false;
+			}
+
+			// input
+			inputVector = {cppflow::tensor(0), cppflow::tensor(0)};
+			setSize(width, height);
+
+			// output
+			outputImage.allocate(size.width, size.height, OF_IMAGE_COLOR);
+			outputFrames = 0;
+			return true;
+		}
+
+		// load & set up model, returns false on error
+		bool load(const std::string & modelPath) {
+			if(!model.load(modelPath)) {
+				return false;
+			}
+			std::vector<std::string> inputNames = {
+				"serving_default_placeholder",
+				"serving_default_placeholder_1"
+			};
+			std::vector<std::string> outputNames = {
+				"StatefulPartitionedCall"
+			};
+			model.setup(inputNames, outputNames);
+			return true;
+		}
+
+		// run model once on blank input & style at an input size
+		void warmUp(int width, int height) {
+			std::size_t len = width * height * 3;
+			cppflow::tensor image(std::vector<float>(len, 0.f),
+				{1, height, width, 3});
+			cppflow::tensor style(std::vector<float>(STYLE_W * STYLE_H * 3, 0.f),
+				{1, STYLE_H, STYLE_W, 3});
+			model.runMultiModel({image, style});
+		}
+
 		// convert ofPixels to a float image tensor
-		cppflow::tensor pixelsToFloatTensor(const ofPixels & pixels) {
+		static cppflow::tensor pixelsToFloatTensor(const ofPixels & pixels) {
 			auto t = ofxTF2::pixelsToTensor(pixels);
 			t = cppflow::expand_dims(t, 0);
 			t = cppflow::cast(t, TF_UINT8, TF_FLOAT);
@@ -241,6 +484,18 @@ class ofxStyleTransfer {
 			return t;
 		}
 
+		// set float image tensor as input, resizes as needed
+		void setInput(cppflow::tensor image, int width, int height) {
+			if(width != size.width || height != size.height) {
+				image = cppflow::resize_bicubic(image, cppflow::tensor({size.height, size.width}), true);
+			}
+			inputVector[0] = image;
+			inputSize = size;
+			newInput = true;
+			inputId++;
+			generation++;
+		}
+
 		// convert float image tensor to ofImage
 		void floatTensorToImage(cppflow::tensor tensor, ofImage & image) {
 			tensor = cppflow::mul(tensor, cppflow::tensor({255.f}));
@@ -248,6 +503,13 @@ class ofxStyleTransfer {
 			ofxTF2::tensorToImage(tensor, image);
 		}
 
+		// convert float image tensor to ofPixels
+		void floatTensorToPixels(cppflow::tensor tensor, ofPixels & pixels) {
+			tensor = cppflow::mul(tensor, cppflow::tensor({255.f}));
+			tensor = cppflow::cast(tensor, TF_FLOAT, TF_UINT8);
+			ofxTF2::tensorToPixels(tensor, pixels);
+		}
+
 		// resize tensor to match ofImage
 		void resizeTensorToImage(cppflow::tensor & tensor, ofImage & image) {
 			tensor = cppflow::resize_bicubic(tensor,
@@ -255,6 +517,391 @@ class ofxStyleTransfer {
 							     (int)outputImage.getWidth()}), true);
 		}
 
+		// (re)allocate output image if pass size changed
+		void allocateOutput(int width, int height) {
+			if(width != outputImage.getWidth() || height != outputImage.getHeight()) {
+				outputImage.allocate(width, height, OF_IMAGE_COLOR);
+			}
+		}
+
+		// get inputs for the next model pass based on the current mode,
+		// returns false if there is nothing to do
+		bool nextPass(std::vector<cppflow::tensor> & inputs) {
+			if(!pending && mode != nextMode && fovea.pass == Fovea::IDLE) {
+				mode = nextMode; // safe to change between inputs
+				if(mode == MODE_TILED && tiles.state.empty()) {
+					setTiles(tiles.cols, tiles.rows, tiles.perPass);
+				}
+				refine.stage = Refine::IDLE;
+			}
+			switch(mode) {
+				case MODE_FOVEATED: return nextFoveaPass(inputs);
+				case MODE_TILED: return nextTilePass(inputs);
+				default: break;
+			}
+			if(refine.enabled) {return nextRefinePass(inputs);}
+			if(streams.inputs.size() > 1) {return nextStreamPass(inputs);}
+			if(!newInput) {return false;}
+			inputs = inputVector;
+			passSize = inputSize;
+			passId = inputId;
+			newInput = false;
+			inputVector[0] = cppflow::tensor(0); // clear input image
+			return true;
+		}
+
+		// handle model pass output, returns true if output image was updated
+		bool passOutput(cppflow::tensor & output) {
+			switch(mode) {
+				case MODE_FOVEATED: return foveaPassOutput(output);
+				case MODE_TILED: return tilePassOutput(output);
+				default: break;
+			}
+			if(refine.pass != Refine::IDLE) {
+				return refinePassOutput(output);
+			}
+			if(!streams.batch.empty()) {
+				return streamPassOutput(output);
+			}
+			allocateOutput(passSize.width, passSize.height);
+			if(modelSize.width != outputImage.getWidth() ||
+			   modelSize.height != outputImage.getHeight()) {
+				resizeTensorToImage(output, outputImage);
+			}
+			floatTensorToImage(output, outputImage);
+			outputImage.update();
+			outputId = passId;
+			return true;
+		}
+
+		// streams: new inputs of all streams of the same size in one batch
+		bool nextStreamPass(std::vector<cppflow::tensor> & inputs) {
+			std::vector<cppflow::tensor> images, styles;
+			streams.batch.clear();
+			if(newInput) {
+				images.push_back(inputVector[0]);
+				streams.batch.push_back(0);
+				passSize = inputSize;
+				passId = inputId;
+				newInput = false;
+				inputVector[0] = cppflow::tensor(0); // clear input image
+			}
+			for(std::size_t i = 1; i < streams.inputs.size(); ++i) {
+				if(!streams.fresh[i]) {continue;}
+				const Size & s = streams.sizes[i];
+				if(streams.batch.empty()) {
+					passSize = s;
+				}
+				if(s.width == passSize.width && s.height == passSize.height) {
+					images.push_back(streams.inputs[i]);
+					streams.batch.push_back(i);
+				} // otherwise stale from before a size change, drop
+				streams.fresh[i] = false;
+				streams.inputs[i] = cppflow::tensor(0);
+			}
+			if(streams.batch.empty()) {return false;}
+			styles.assign(images.size(), inputVector[1]);
+			if(images.size() == 1) {
+				inputs = {images[0], styles[0]};
+			}
+			else {
+				inputs = {cppflow::concat(cppflow::tensor(0), images),
+				          cppflow::concat(cppflow::tensor(0), styles)};
+			}
+			return true;
+		}
+
+		// streams: split batch output into the stream output images
+		bool streamPassOutput(cppflow::tensor & output) {
+			for(std::size_t b = 0; b < streams.batch.size(); ++b) {
+				std::size_t stream = streams.batch[b];
+				ofImage & image = getOutput(stream);
+				if(passSize.width != image.getWidth() || passSize.height != image.getHeight()) {
+					image.allocate(passSize.width, passSize.height, OF_IMAGE_COLOR);
+				}
+				auto t = (streams.batch.size() == 1 ? output :
+				          cppflow::slice(output, cppflow::tensor({(int)b, 0, 0, 0}),
+				                                 cppflow::tensor({1, -1, -1, -1})));
+				if(modelSize.width != image.getWidth() || modelSize.height != image.getHeight()) {
+					t = cppflow::resize_bicubic(t, cppflow::tensor({(int)image.getHeight(),
+					                                                (int)image.getWidth()}), true);
+				}
+				floatTensorToImage(t, image);
+				image.update();
+				if(stream == 0) {outputId = passId;}
+			}
+			streams.batch.clear();
+			return true;
+		}
+
+		// refine: low res preview pass, then full res pass of the same input
+		bool nextRefinePass(std::vector<cppflow::tensor> & inputs) {
+			if(newInput) {
+				refine.input = inputVector[0];
+				refine.size = inputSize;
+				newInput = false;
+				inputVector[0] = cppflow::tensor(0); // clear input image
+				refine.stage = Refine::PREVIEW_NEXT;
+			}
+			switch(refine.stage) {
+				case Refine::PREVIEW_NEXT: {
+					int w = std::max(roundupto(refine.size.width * refine.scale, 32), 32);
+					int h = std::max(roundupto(refine.size.height * refine.scale, 32), 32);
+					inputs = {cppflow::resize_bicubic(refine.input, cppflow::tensor({h, w}), true),
+					          inputVector[1]};
+					refine.stage = Refine::PREVIEW;
+					break;
+				}
+				case Refine::FULL_NEXT:
+					inputs = {refine.input, inputVector[1]};
+					refine.stage = Refine::FULL;
+					break;
+				default:
+					return false;
+			}
+			refine.pass = refine.stage;
+			refine.generation = generation;
+			return true;
+		}
+
+		// refine: show upscaled preview or full res output, drop stale output
+		bool refinePassOutput(cppflow::tensor & output) {
+			Refine::Stage pass = refine.pass;
+			refine.pass = Refine::IDLE;
+			if(refine.generation != generation) {
+				// input or style changed while processing, start over
+				if(refine.enabled && !newInput && refine.stage != Refine::IDLE) {
+					refine.stage = Refine::PREVIEW_NEXT;
+				}
+				return false;
+			}
+			int w = refine.size.width, h = refine.size.height;
+			allocateOutput(w, h);
+			if(pass == Refine::PREVIEW) {
+				output = cppflow::resize_bilinear(output, cppflow::tensor({h, w}), false, true);
+				refine.stage = Refine::FULL_NEXT;
+			}
+			else {
+				if(modelSize.width != w || modelSize.height != h) {
+					resizeTensorToImage(output, outputImage);
+				}
+				refine.stage = Refine::DONE;
+			}
+			floatTensorToImage(output, outputImage);
+			outputImage.update();
+			return true;
+		}
+
+		// foveated: low res pass of the whole input, then full res crop pass
+		bool nextFoveaPass(std::vector<cppflow::tensor> & inputs) {
+			switch(fovea.pass) {
+				case Fovea::IDLE: {
+					if(!newInput) {return false;}
+					fovea.input = inputVector[0];
+					fovea.size = inputSize;
+					newInput = false;
+					inputVector[0] = cppflow::tensor(0); // clear input image
+
+					// crop rect in input pixels, multiples of 32 & within bounds
+					int maxW = std::max(fovea.size.width - fovea.size.width % 32, 32);
+					int maxH = std::max(fovea.size.height - fovea.size.height % 32, 32);
+					int w = ofClamp(roundupto(fovea.region.width * fovea.size.width, 32), 32, maxW);
+					int h = ofClamp(roundupto(fovea.region.height * fovea.size.height, 32), 32, maxH);
+					int cx = (fovea.region.x + fovea.region.width * 0.5) * fovea.size.width;
+					int cy = (fovea.region.y + fovea.region.height * 0.5) * fovea.size.height;
+					fovea.crop.set(ofClamp(cx - w / 2, 0, std::max(fovea.size.width - w, 0)),
+					               ofClamp(cy - h / 2, 0, std::max(fovea.size.height - h, 0)), w, h);
+
+					// low res pass
+					int lw = std::max(roundupto(fovea.size.width * fovea.scale, 32), 32);
+					int lh = std::max(roundupto(fovea.size.height * fovea.scale, 32), 32);
+					inputs = {cppflow::resize_bicubic(fovea.input, cppflow::tensor({lh, lw}), true),
+					          inputVector[1]};
+					fovea.pass = Fovea::LOW;
+					return true;
+				}
+				case Fovea::LOW_DONE: {
+					int x = fovea.crop.x, y = fovea.crop.y;
+					int w = fovea.crop.width, h = fovea.crop.height;
+					inputs = {cppflow::slice(fovea.input, cppflow::tensor({0, y, x, 0}),
+					                                      cppflow::tensor({1, h, w, 3})),
+					          inputVector[1]};
+					fovea.pass = Fovea::CROP;
+					return true;
+				}
+				default:
+					return false;
+			}
+		}
+
+		// foveated: keep low res output, composite once crop output is done
+		bool foveaPassOutput(cppflow::tensor & output) {
+			if(fovea.pass == Fovea::LOW) {
+				fovea.low = output;
+				fovea.pass = Fovea::LOW_DONE;
+				return false;
+			}
+			if(fovea.pass != Fovea::CROP) {return false;}
+			int W = fovea.size.width, H = fovea.size.height;
+			int x = fovea.crop.x, y = fovea.crop.y;
+			int w = fovea.crop.width, h = fovea.crop.height;
+			auto low = cppflow::resize_bilinear(fovea.low, cppflow::tensor({H, W}), false, true);
+			auto paddings = cppflow::tensor(std::vector<int>{0, 0, y, H-y-h, x, W-x-w, 0, 0}, {4, 2});
+			auto crop = cppflow::pad(output, paddings);
+			auto mask = cppflow::pad(foveaMask(), paddings);
+			auto composite = cppflow::add(low, cppflow::mul(mask, cppflow::sub(crop, low)));
+			allocateOutput(W, H);
+			floatTensorToImage(composite, outputImage);
+			outputImage.update();
+			fovea.input = cppflow::tensor(0);
+			fovea.low = cppflow::tensor(0);
+			fovea.pass = Fovea::IDLE;
+			return true;
+		}
+
+		// tiled: batch next dirty tile(s) from the latest input, new input marks
+		// all tiles as dirty
+		bool nextTilePass(std::vector<cppflow::tensor> & inputs) {
+			if(newInput) {
+				tiles.input = inputVector[0];
+				newInput = false;
+				inputVector[0] = cppflow::tensor(0); // clear input image
+				if(tiles.size.width != inputSize.width || tiles.size.height != inputSize.height) {
+					updateTileRects(inputSize.width, inputSize.height);
+				}
+				for(auto & tile : tiles.state) {tile.dirty = true;}
+			}
+
+			// choose tiles: oldest first, optionally weighted by motion
+			tiles.batch.clear();
+			for(int n = 0; n < tiles.perPass; ++n) {
+				int next = -1;
+				float best = -1;
+				for(int i = 0; i < (int)tiles.state.size(); ++i) {
+					Tiles::State & tile = tiles.state[i];
+					if(!tile.dirty || std::find(tiles.batch.begin(), tiles.batch.end(), i) != tiles.batch.end()) {
+						continue;
+					}
+					float score = tile.age * 0.01f;
+					if(tiles.order == TILE_ORDER_MOTION) {
+						score += tile.motion;
+					}
+					if(score > best) {
+						best = score;
+						next = i;
+					}
+				}
+				if(next < 0) {break;}
+				tiles.batch.push_back(next);
+			}
+			if(tiles.batch.empty()) {return false;}
+
+			// batch of same sized tile crops & matching style batch
+			int w = tiles.tileSize.width, h = tiles.tileSize.height;
+			std::vector<cppflow::tensor> crops, styles;
+			for(int i : tiles.batch) {
+				const ofRectangle & r = tiles.state[i].input;
+				crops.push_back(cppflow::slice(tiles.input,
+					cppflow::tensor({0, (int)r.y, (int)r.x, 0}), cppflow::tensor({1, h, w, 3})));
+				styles.push_back(inputVector[1]);
+			}
+			if(crops.size() == 1) {
+				inputs = {crops[0], styles[0]};
+			}
+			else {
+				inputs = {cppflow::concat(cppflow::tensor(0), crops),
+				          cppflow::concat(cppflow::tensor(0), styles)};
+			}
+			for(auto & tile : tiles.state) {tile.age++;}
+			for(int i : tiles.batch) {
+				tiles.state[i].dirty = false;
+				tiles.state[i].motion = 0;
+				tiles.state[i].age = 0;
+			}
+			return true;
+		}
+
+		// tiled: crop tile centers from the batch output & write into output image
+		bool tilePassOutput(cppflow::tensor & output) {
+			if(tiles.batch.empty()) {return false;}
+			if(tiles.size.width != outputImage.getWidth() ||
+			   tiles.size.height != outputImage.getHeight()) {
+				outputImage.allocate(tiles.size.width, tiles.size.height, OF_IMAGE_COLOR);
+				outputImage.getPixels().set(0);
+			}
+			for(int b = 0; b < (int)tiles.batch.size(); ++b) {
+				const Tiles::State & tile = tiles.state[tiles.batch[b]];
+				int x = tile.core.x - tile.input.x, y = tile.core.y - tile.input.y;
+				int w = tile.core.width, h = tile.core.height;
+				if(w <= 0 || h <= 0) {continue;}
+				auto core = cppflow::slice(output, cppflow::tensor({b, y, x, 0}),
+				                                   cppflow::tensor({1, h, w, 3}));
+				floatTensorToPixels(core, tiles.pixels);
+				tiles.pixels.pasteInto(outputImage.getPixels(), tile.core.x, tile.core.y);
+			}
+			outputImage.update();
+			tiles.batch.clear();
+			return true;
+		}
+
+		// compute tile core & input rects for an input size, all tile inputs
+		// have the same size (multiples of 32) & extend past the core by a
+		// margin to give each tile context, reducing seams between tiles
+		void updateTileRects(int width, int height) {
+			tiles.size.width = width;
+			tiles.size.height = height;
+			int maxW = std::max(width - width % 32, 32);
+			int maxH = std::max(height - height % 32, 32);
+			int cw = ceil((float)width / tiles.cols);
+			int ch = ceil((float)height / tiles.rows);
+			tiles.tileSize.width = ofClamp(roundupto(cw + 2 * Tiles::MARGIN, 32), 32, maxW);
+			tiles.tileSize.height = ofClamp(roundupto(ch + 2 * Tiles::MARGIN, 32), 32, maxH);
+			for(int i = 0; i < (int)tiles.state.size(); ++i) {
+				Tiles::State & tile = tiles.state[i];
+				int x = (i % tiles.cols) * cw, y = (i / tiles.cols) * ch;
+				tile.core.set(x, y, std::max(std::min(cw, width - x), 0),
+				                    std::max(std::min(ch, height - y), 0));
+				int tx = ofClamp(x + tile.core.width / 2 - tiles.tileSize.width / 2,
+				                 0, std::max(width - tiles.tileSize.width, 0));
+				int ty = ofClamp(y + tile.core.height / 2 - tiles.tileSize.height / 2,
+				                 0, std::max(height - tiles.tileSize.height, 0));
+				tile.input.set(tx, ty, tiles.tileSize.width, tiles.tileSize.height);
+
+				// core must fit inside the tile input if the tile is too small
+				tile.core = tile.core.getIntersection(tile.input);
+			}
+		}
+
+		// feathered crop mask, 1 inside & fading to 0 at the crop edges, edges
+		// touching the input bounds are not feathered, cached until changed
+		cppflow::tensor & foveaMask() {
+			int w = fovea.crop.width, h = fovea.crop.height;
+			bool left = fovea.crop.x > 0, top = fovea.crop.y > 0;
+			bool right = fovea.crop.x + w < fovea.size.width;
+			bool bottom = fovea.crop.y + h < fovea.size.height;
+			int key = (left ? 1 : 0) | (top ? 2 : 0) | (right ? 4 : 0) | (bottom ? 8 : 0);
+			if(w == fovea.maskSize.width && h == fovea.maskSize.height &&
+			   key == fovea.maskKey && fovea.maskFeather == fovea.feather) {
+				return fovea.mask;
+			}
+			float feather = std::max(fovea.feather * std::min(w, h), 1.f);
+			std::vector<float> values(w * h);
+			for(int j = 0; j < h; ++j) {
+				float dy = std::min(top ? j : h, bottom ? h - 1 - j : h);
+				for(int i = 0; i < w; ++i) {
+					float dx = std::min(left ? i : w, right ? w - 1 - i : w);
+					float t = ofClamp(std::min(dx, dy) / feather, 0, 1);
+					values[j * w + i] = t * t * (3 - 2 * t); // smoothstep
+				}
+			}
+			fovea.mask = cppflow::tensor(values, {1, h, w, 1});
+			fovea.maskSize.width = w;
+			fovea.maskSize.height = h;
+			fovea.maskKey = key;
+			fovea.maskFeather = fovea.feather;
+			return fovea.mask;
+		}
+
 	private:
 
 		struct Size {
@@ -263,10 +910,101 @@ class ofxStyleTransfer {
 		};
 		struct Size size; ///< pixel input (& output) size
 		struct Size modelSize; ///< pixel size for the model, multiples of 32
+		struct Size inputSize; ///< pixel size of the current input tensor
+		struct Size passSize; ///< pixel size of the current full pass
 		std::vector<cppflow::tensor> inputVector; // {input image, style image}
 		ofImage outputImage; ///< output image
 		bool newInput = false; ///< is the input tensor new?
+		bool pending = false; ///< is a pass being processed? non-blocking only
+		unsigned long inputId = 0; ///< last input id
+		unsigned long passId = 0; ///< input id of the current full pass
+		unsigned long outputId = 0; ///< input id of the current full output
 
-		/// size change between input & output? used when non-blocking only
-		bool sizeChanged = false;
+		Mode mode = MODE_FULL; ///< current processing mode
+		Mode nextMode = MODE_FULL; ///< requested processing mode
+		unsigned int generation = 0; ///< input & style change counter
+
+		/// progressive refinement state
+		struct Refine {
+			enum Stage {
+				IDLE,         ///< waiting for input
+				PREVIEW_NEXT, ///< preview pass next
+				PREVIEW,      ///< processing preview pass
+				FULL_NEXT,    ///< full res pass next
+				FULL,         ///< processing full res pass
+				DONE          ///< full res pass done, keeps input for style changes
+			};
+			bool enabled = false; ///< refine progressively?
+			Stage stage = IDLE; ///< current stage
+			Stage pass = IDLE; ///< stage of the pass being processed, if any
+			float scale = 0.25; ///< preview pass scale
+			struct Size size; ///< pixel size of the current input
+			cppflow::tensor input; ///< current input
+			unsigned int generation = 0; ///< generation of the current pass
+		} refine;
+
+		/// foveated mode state
+		struct Fovea {
+			enum Pass {
+				IDLE,     ///< waiting for input
+				LOW,      ///< processing low res pass
+				LOW_DONE, ///< low res pass done, crop pass next
+				CROP      ///< processing crop pass
+			};
+			Pass pass = IDLE; ///< current pass
+			ofRectangle region = {0.25, 0.25, 0.5, 0.5}; ///< normalized region of interest
+			float scale = 0.5; ///< low res pass scale
+			float feather = 0.15; ///< mask feather as percent of crop size
+			struct Size size; ///< pixel size of the current input
+			ofRectangle crop; ///< crop rect of the current input in pixels
+			cppflow::tensor input; ///< current input
+			cppflow::tensor low; ///< low res pass output
+			cppflow::tensor mask; ///< cached crop mask
+			struct Size maskSize; ///< cached crop mask size
+			int maskKey = -1; ///< cached crop mask feathered edges
+			float maskFeather = -1; ///< cached crop mask feather
+		} fovea;
+
+		/// tiled mode state
+		struct Tiles {
+			static const int MARGIN = 32; ///< tile context margin in pixels
+			struct State {
+				ofRectangle core; ///< rect written to the output in pixels
+				ofRectangle input; ///< rect processed in pixels, core + margin
+				bool dirty = true; ///< has input changed since last processed?
+				float motion = 0; ///< accumulated motion since last processed
+				int age = 0; ///< passes since last processed
+			};
+			int cols = 2; ///< grid columns
+			int rows = 2; ///< grid rows
+			int perPass = 1; ///< tiles per pass
+			TileOrder order = TILE_ORDER_ROUND_ROBIN; ///< processing order
+			std::vector<State> state; ///< per-tile state
+			std::vector<int> batch; ///< tile indices in the current pass
+			struct Size size = {0, 0}; ///< input size the rects are computed for
+			struct Size tileSize; ///< tile input size in pixels, multiples of 32
+			cppflow::tensor input; ///< latest input
+			ofPixels pixels; ///< tile output conversion buffer
+		} tiles;
+
+		/// input streams state, stream 0 uses the regular input & output
+		struct Streams {
+			std::vector<cppflow::tensor> inputs; ///< latest input per stream
+			std::vector<struct Size> sizes; ///< pixel size per input
+			std::vector<bool> fresh; ///< is the stream input new?
+			std::vector<ofImage> outputs; ///< output per stream
+			std::vector<std::size_t> batch; ///< stream indices in the current pass
+		} streams;
+
+		// model loading
+		enum LoadState {
+			NOT_LOADED,
+			LOADING,
+			LOADED,
+			LOAD_FAILED
+		};
+		std::atomic<int> loadState{NOT_LOADED}; ///< LoadState
+		std::thread loader; ///< background loading thread, if used
+		bool startOnLoad = false; ///< start processing thread once loaded?
+		unsigned int outputFrames = 0; ///< number of output images processed
 };